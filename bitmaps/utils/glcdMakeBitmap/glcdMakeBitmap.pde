@@ -13,6 +13,11 @@ import java.awt.datatransfer.*;
 
 String destinationOffset  ;
 String aggregateHeader = "allBitmaps.h";
+boolean makeShifted = false;  // also write the pre-shifted copies used by glcd_SpriteCache
+boolean makeRLE = false;      // also write the run length encoded image drawn by DrawBitmapRLE()
+int animFrameHeight = 0;      // if not 0 the image is frames this high one above the other,
+                              // also written as an animation for glcd_Animation
+int animInterval = 100;       // milliseconds from one animation frame to the next
 
 PImage bitmap;
 PFont aFont;
@@ -152,12 +157,167 @@ void writeFile()
     }
   }  
   output.print("\n};\n");
+  if(makeShifted)
+    writeShifted(output);
+  if(makeRLE)
+    writeRLE(output);
+  if(animFrameHeight > 0 && imgData.height / animFrameHeight > 0)
+    writeAnimation(output);
   output.println("#endif");
 
   output.flush(); // Write the remaining data
   output.close(); // Finish the file
 }
 
+// write the 8 copies of the image shifted down 0 to 7 rows for a glcd_SpriteCache
+void writeShifted(PrintWriter output) {
+  int bands = (imgData.height + 14)/8;
+  output.println();
+  output.print("static uint8_t ");
+  output.print(imgData.baseName);
+  output.println("_shifted[] PROGMEM = {");
+  output.println("  " + imgData.width + ", // width");
+  output.println("  " + imgData.height + ", // height");
+  output.print("  0, // no mask");
+  for(int shift=0; shift < 8; shift++) {
+    output.println("\n\n  /* shifted down " + shift + " */");
+    output.print("  ");
+    for(int band=0; band < bands; band++) {
+      for(int x=0; x < imgData.width; x++) {
+        int val = 0;
+        for(int bit=0; bit < 8; bit++) {
+          int y = band * 8 + bit - shift;
+          if(y >= 0 && y < imgData.height && isDark(x, y))
+            val |= (1 << bit);
+        }
+        output.print("0x" + Integer.toHexString(val));
+        if(shift < 7 || band < bands-1 || x < imgData.width-1)
+          output.print(",");
+        if(x % 16 == 15 || x == imgData.width-1)
+          output.print("\n  ");
+      }
+    }
+  }
+  output.print("\n};\n");
+}
+
+// write the image as runs of bytes for DrawBitmapRLE()
+void writeRLE(PrintWriter output) {
+  int count = imgData.width * imgData.pages;
+  int[] data = new int[count];
+  for(int page=0; page < imgData.pages; page++)
+    for(int x=0; x < imgData.width; x++)
+      data[page * imgData.width + x] = getValue(x, page);
+  int[] runs = new int[2 * count];
+  int len = encodeRuns(data, null, runs);
+
+  output.println();
+  output.print("static uint8_t ");
+  output.print(imgData.baseName);
+  output.println("_rle[] PROGMEM = {");
+  output.println("  " + imgData.width + ", // width");
+  output.print("  " + imgData.height + ", // height");
+  writeBytes(output, runs, len, true);
+  output.print("\n};\n");
+}
+
+// write the image as an animation for glcd_Animation, the frames are animFrameHeight
+// rows each one above the other. That is frame 0, then only the bytes that change
+// from each frame to the next, ending with the changes back to frame 0
+void writeAnimation(PrintWriter output) {
+  int frames = imgData.height / animFrameHeight;
+  int pages = (animFrameHeight + 7)/8;
+  int count = imgData.width * pages;
+  int[][] data = new int[frames][count];
+  for(int f=0; f < frames; f++)
+    for(int page=0; page < pages; page++)
+      for(int x=0; x < imgData.width; x++) {
+        int val = 0;
+        for(int bit=0; bit < 8; bit++) {
+          int y = page * 8 + bit;
+          if(y < animFrameHeight && isDark(x, f * animFrameHeight + y))
+            val |= (1 << bit);
+        }
+        data[f][page * imgData.width + x] = val;
+      }
+  int[] runs = new int[2 * count];
+
+  output.println();
+  output.print("static uint8_t ");
+  output.print(imgData.baseName);
+  output.println("_anim[] PROGMEM = {");
+  output.println("  " + imgData.width + ", // width");
+  output.println("  " + animFrameHeight + ", // height");
+  output.println("  " + frames + ", // frames");
+  output.print("  " + (animInterval & 0xff) + ", " + (animInterval >> 8) + ", // milliseconds per frame");
+  for(int f=0; f <= frames; f++) {
+    int len = encodeRuns(data[f % frames], f > 0 ? data[f - 1] : null, runs);
+    if(f == 0)
+      output.print("\n\n  /* frame 0 */");
+    else
+      output.print("\n\n  /* changes to frame " + (f % frames) + " */");
+    output.print("\n  " + (len & 0xff) + ", " + (len >> 8) + ", // length");
+    writeBytes(output, runs, len, f == frames);
+  }
+  output.print("\n};\n");
+}
+
+// encode the bytes of an image as runs, returns the number of bytes put in runs.
+// A code byte of 0-127 is followed by code+1 image bytes, 128-191 by one byte
+// repeated code-127 times and 192-255 skips code-191 bytes that are the same in prev
+int encodeRuns(int[] data, int[] prev, int[] runs) {
+  int count = data.length;
+  int len = 0;
+  int i = 0;
+  while(i < count) {
+    int n = 1;
+    if(prev != null && prev[i] == data[i]) {
+      while(i + n < count && n < 64 && prev[i + n] == data[i + n])
+        n++;
+      runs[len++] = 0xc0 + n - 1;
+    }
+    else {
+      while(i + n < count && n < 64 && data[i + n] == data[i] && !(prev != null && prev[i + n] == data[i + n]))
+        n++;
+      if(n >= 3) {
+        runs[len++] = 0x80 + n - 1;
+        runs[len++] = data[i];
+      }
+      else {
+        // image bytes up to the next run of 3 or more the same or bytes to skip
+        n = 1;
+        while(i + n < count && n < 128 && !(prev != null && prev[i + n] == data[i + n]) &&
+              !(i + n + 2 < count && data[i + n] == data[i + n + 1] && data[i + n] == data[i + n + 2]))
+          n++;
+        runs[len++] = n - 1;
+        for(int j=0; j < n; j++)
+          runs[len++] = data[i + j];
+      }
+    }
+    i += n;
+  }
+  return len;
+}
+
+// write len bytes as hex 16 to a line, with a comma after each unless it is the last
+void writeBytes(PrintWriter output, int[] bytes, int len, boolean last) {
+  for(int i=0; i < len; i++) {
+    if(i % 16 == 0)
+      output.print("\n  ");
+    else
+      output.print(" ");
+    output.print("0x" + Integer.toHexString(bytes[i]));
+    if(i < len - 1 || !last)
+      output.print(",");
+  }
+}
+
+// true if the pixel at x,y is closer to dark than light
+boolean isDark(int x, int y) {
+  int c = bitmap.pixels[y * imgData.width + x];
+  return ((c >> 16) & 0xFF) < 128 || ((c >> 8) & 0xFF) < 128 || (c & 0xFF) < 128;
+}
+
 // return the byte representing data a the given page and x offset
 int getValue( int x, int page) {  
   //print("page= ");println(page);
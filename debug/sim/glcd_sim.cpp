@@ -0,0 +1,559 @@
+/*
+  glcd_sim.cpp - host side simulated glcd module
+
+  vi:ts=4
+
+  This file is part of the Arduino GLCD library.
+
+  GLCD is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation, either version 2.1 of the License, or
+  (at your option) any later version.
+
+  GLCD is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with GLCD.  If not, see <http://www.gnu.org/licenses/>.
+
+  This is a pin level model of a ks0108 style glcd module and of the MCP23S17
+  port expander used by GLCD_BITSHIFT_COMMS.
+
+  The model watches the same control lines the real module does.
+  Chip selects and E are decoded using the glcd_CHIPx strings and the
+  glcdEN/glcdE1/glcdE2 pin defines from the active configuration,
+  commands are decoded using the LCD_xxx defines from the device header.
+  Each chip has its own page/column registers, RAM, output latch and busy timer.
+
+  The module is modeled closely enough that the library has to do the
+  same things it does on real hardware:
+	- a dummy read is needed after setting the address
+	- the column advances after every data read or write
+	- status reads show BUSY for GLCDSIM_tBUSY ns after each command or data write
+	- cycles started while the chip is busy are dropped and counted as overruns
+
+  With GLCDSIM_DISPLAYS > 1 there are that many identical modules on the bus,
+  the library selects one with glcd_DevSelectDisplay() (see glcd_io.h).
+
+  Time only advances when the library does i/o or delays, so the
+  bus time reported is the time the AVR would spend talking to the module.
+
+*/
+
+#include <string.h>
+#include "Arduino.h"
+#include "include/glcd_Device.h"
+#include "include/glcd_io.h"
+
+#ifdef GLCD_BITSHIFT_COMMS
+#include <MCP23S17.h>	// for the register defines
+#endif
+
+/*
+ * Module geometry
+ */
+#define GLCDSIM_PAGES	((CHIP_HEIGHT+7)/8)
+
+#if defined(LCD_SET_ADD) && (LCD_SET_ADD == 0x40)
+#define GLCDSIM_COLS	64		// ks0108 column counter is 6 bits
+#else
+#define GLCDSIM_COLS	256
+#endif
+
+/*
+ * Command decoding masks derived from the device header
+ */
+#if (LCD_SET_PAGE & 0x08)
+#define GLCDSIM_PAGEMASK	0x07
+#else
+#define GLCDSIM_PAGEMASK	0x0f
+#endif
+
+#ifdef LCD_SET_ADD
+#if LCD_SET_ADD == 0
+#define GLCDSIM_ADDMASK		0x80
+#else
+#define GLCDSIM_ADDMASK		0xc0
+#endif
+#endif
+
+/*
+ * Chip select decoding, the mirror image of lcdChipSelect() in glcd_io.h
+ */
+#define glcdsim_CSmatch1(p,v)	(glcdsim_pins[p] == (v))
+#define glcdsim_CSmatch2(p1,v1, p2,v2) \
+	(glcdsim_CSmatch1(p1,v1) && glcdsim_CSmatch1(p2,v2))
+#define glcdsim_CSmatch3(p1,v1, p2,v2, p3,v3) \
+	(glcdsim_CSmatch2(p1,v1, p2,v2) && glcdsim_CSmatch1(p3,v3))
+#define glcdsim_CSmatch4(p1,v1, p2,v2, p3,v3, p4,v4) \
+	(glcdsim_CSmatch2(p1,v1, p2,v2) && glcdsim_CSmatch2(p3,v3, p4,v4))
+
+#if defined(glcdCSEL4)
+#define glcdsim_IsChip(cselstr) glcdsim_CSmatch4(cselstr)
+#elif defined(glcdCSEL3)
+#define glcdsim_IsChip(cselstr) glcdsim_CSmatch3(cselstr)
+#elif defined(glcdCSEL2)
+#define glcdsim_IsChip(cselstr) glcdsim_CSmatch2(cselstr)
+#elif defined(glcdCSEL1)
+#define glcdsim_IsChip(cselstr) glcdsim_CSmatch1(cselstr)
+#endif
+
+/// @cond hide_from_doxygen
+typedef struct
+{
+	uint8_t page;
+	uint8_t col;
+	uint8_t latch;		// output register for data reads
+	uint8_t on;
+	uint8_t startline;
+	uint64_t busy_until;
+	uint8_t ram[GLCDSIM_PAGES][GLCDSIM_COLS];
+} glcdsim_chip_t;
+/// @endcond
+
+glcdsim_stats_t glcdsim_stats;
+
+static glcdsim_chip_t glcdsim_chip[GLCDSIM_DISPLAYS][glcd_CHIP_COUNT];
+static uint8_t glcdsim_display;		// module the control lines are routed to
+static uint8_t glcdsim_pins[256];
+static uint64_t glcdsim_clock;		// simulated time in ns
+static uint32_t glcdsim_tbusy = GLCDSIM_tBUSY;	// controller busy time, see glcdsim_SetBusyTime()
+
+static uint8_t glcdsim_echip;		// chip that E is currently strobing
+static uint8_t glcdsim_lcddrive;	// module is driving the data lines
+static uint8_t glcdsim_lcdout;		// value module is driving
+static uint8_t glcdsim_hostdrv;		// data lines driven by the host (1 bits)
+static uint8_t glcdsim_hostdata;	// value host is driving
+
+#ifdef GLCD_BITSHIFT_COMMS
+static uint8_t glcdsim_mcpregs[OLATB+1];
+static uint8_t glcdsim_ss;			// level of the SPI slave select line (active low)
+static uint8_t glcdsim_spistate;
+static uint8_t glcdsim_spiop;
+static uint8_t glcdsim_spiaddr;
+#endif
+
+/*
+ * cycle type is determined by DI and RW
+ */
+static uint8_t glcdsim_CycleType(void)
+{
+	if(glcdsim_pins[glcdRW])
+		return(glcdsim_pins[glcdDI] ? GLCDSIM_READ : GLCDSIM_STATUS);
+	else
+		return(glcdsim_pins[glcdDI] ? GLCDSIM_WRITE : GLCDSIM_CMD);
+}
+
+/*
+ * advance the clock and charge the time to the current cycle type
+ */
+static void glcdsim_Tick(uint32_t ns)
+{
+	glcdsim_clock += ns;
+	glcdsim_stats.ns[glcdsim_CycleType()] += ns;
+}
+
+static uint8_t glcdsim_Busy(uint8_t chip)
+{
+	return(glcdsim_clock < glcdsim_chip[glcdsim_display][chip].busy_until);
+}
+
+static uint8_t glcdsim_Status(uint8_t chip)
+{
+	uint8_t status = 0;
+
+	if(glcdsim_Busy(chip))
+		status |= LCD_BUSY_FLAG;
+	return(status);
+}
+
+/*
+ * value on the data lines as seen by the host
+ */
+static uint8_t glcdsim_Bus(void)
+{
+uint8_t data = 0xff; // undriven lines float/pull high
+
+	if(glcdsim_lcddrive)
+	{
+		/*
+		 * status output tracks the busy flag for as long as E is held high
+		 */
+		if(glcdsim_CycleType() == GLCDSIM_STATUS)
+		{
+			glcdsim_lcdout = glcdsim_Status(glcdsim_echip);
+			glcdsim_stats.polls++;
+		}
+		data = glcdsim_lcdout;
+	}
+	return((data & ~glcdsim_hostdrv) | (glcdsim_hostdata & glcdsim_hostdrv));
+}
+
+static void glcdsim_Command(glcdsim_chip_t *cp, uint8_t cmd)
+{
+	if(cmd == LCD_ON)
+		cp->on = 1;
+	else if(cmd == LCD_OFF)
+		cp->on = 0;
+	else if((cmd & ~GLCDSIM_PAGEMASK) == LCD_SET_PAGE)
+		cp->page = (cmd & GLCDSIM_PAGEMASK) % GLCDSIM_PAGES;
+#ifdef LCD_SET_ADDLO
+	else if((cmd & 0xf0) == LCD_SET_ADDLO)
+		cp->col = (cp->col & 0xf0) | (cmd & 0x0f);
+	else if((cmd & 0xf0) == LCD_SET_ADDHI)
+		cp->col = (cp->col & 0x0f) | ((cmd & 0x0f) << 4);
+#else
+	else if((cmd & GLCDSIM_ADDMASK) == LCD_SET_ADD)
+		cp->col = (cmd & ~GLCDSIM_ADDMASK) % GLCDSIM_COLS;
+#endif
+	else if((cmd & 0xc0) == (LCD_DISP_START & 0xc0))
+		cp->startline = cmd & 0x3f;
+	/*
+	 * anything else is a mode setting the model doesn't care about
+	 */
+}
+
+static void glcdsim_Strobe(uint8_t chip, uint8_t level)
+{
+glcdsim_chip_t *cp = &glcdsim_chip[glcdsim_display][chip];
+uint8_t type = glcdsim_CycleType();
+
+	if(level)
+	{
+		glcdsim_echip = chip;
+		glcdsim_stats.cycles[type]++;
+
+		if(type == GLCDSIM_STATUS)
+		{
+			glcdsim_lcdout = glcdsim_Status(chip);
+			glcdsim_lcddrive = 1;
+		}
+		else if(type == GLCDSIM_READ)
+		{
+			if(glcdsim_Busy(chip))
+			{
+				glcdsim_stats.overruns++;
+				glcdsim_lcdout = 0xff;
+			}
+			else
+			{
+				/*
+				 * output what was latched by the previous read
+				 * then latch the current location and advance.
+				 * This is why a dummy read is needed after setting the address.
+				 */
+				glcdsim_lcdout = cp->latch;
+				cp->latch = cp->ram[cp->page][cp->col];
+				cp->col = (cp->col + 1) % GLCDSIM_COLS;
+			}
+			glcdsim_lcddrive = 1;
+		}
+		return;
+	}
+
+	/*
+	 * falling edge, writes are latched here
+	 */
+	glcdsim_lcddrive = 0;
+
+	if(type == GLCDSIM_CMD || type == GLCDSIM_WRITE)
+	{
+		uint8_t data = glcdsim_Bus();
+
+		if(glcdsim_Busy(chip))
+		{
+			glcdsim_stats.overruns++;
+			return;
+		}
+
+		if(type == GLCDSIM_CMD)
+		{
+			glcdsim_Command(cp, data);
+		}
+		else
+		{
+			cp->ram[cp->page][cp->col] = data;
+			cp->col = (cp->col + 1) % GLCDSIM_COLS;
+		}
+		cp->busy_until = glcdsim_clock + glcdsim_tbusy;
+	}
+}
+
+/*
+ * Decode which chip a strobe on the given E line is for
+ */
+static uint8_t glcdsim_DecodeChip(uint8_t pin)
+{
+#ifdef glcdE2
+	if(pin == glcdE2)
+		return(1);
+#else
+	(void)pin;		// E is shared, the chip selects decide
+#endif
+
+#ifdef glcd_CHIP3
+	if(glcdsim_IsChip(glcd_CHIP3)) return(3);
+#endif
+#ifdef glcd_CHIP2
+	if(glcdsim_IsChip(glcd_CHIP2)) return(2);
+#endif
+#ifdef glcd_CHIP1
+	if(glcdsim_IsChip(glcd_CHIP1)) return(1);
+#endif
+	return(0);
+}
+
+void glcdsim_WritePin(uint8_t pin, uint8_t val)
+{
+uint8_t old = glcdsim_pins[pin];
+
+	glcdsim_Tick(GLCDSIM_tIO);
+	glcdsim_pins[pin] = val;
+
+#ifdef GLCD_BITSHIFT_COMMS
+	if(pin == SS)
+	{
+		glcdsim_SpiSelect(val);
+		return;
+	}
+#endif
+
+	if(old == val)
+		return;
+
+#ifdef glcdEN
+	if(pin == glcdEN)
+		glcdsim_Strobe(val ? glcdsim_DecodeChip(pin) : glcdsim_echip, val);
+#endif
+#ifdef glcdE1
+	if(pin == glcdE1 || pin == glcdE2)
+		glcdsim_Strobe(glcdsim_DecodeChip(pin), val);
+#endif
+}
+
+void glcdsim_DataDir(uint8_t dirbits)
+{
+	glcdsim_Tick(GLCDSIM_tIO);
+	glcdsim_hostdrv = dirbits;
+}
+
+void glcdsim_DataOut(uint8_t data)
+{
+	glcdsim_Tick(GLCDSIM_tIO);
+	glcdsim_hostdata = data;
+}
+
+uint8_t glcdsim_DataIn(void)
+{
+	glcdsim_Tick(GLCDSIM_tIO);
+	return(glcdsim_Bus());
+}
+
+uint8_t glcdsim_RdBusy(void)
+{
+	return((glcdsim_DataIn() & LCD_BUSY_FLAG) != 0);
+}
+
+void glcdsim_Delay(uint32_t ns)
+{
+	glcdsim_Tick(ns);
+}
+
+void glcdsim_DelayMilliseconds(uint32_t ms)
+{
+	/*
+	 * not bus time, but the module still sees time go by
+	 */
+	glcdsim_clock += (uint64_t) ms * 1000000;
+}
+
+/*
+ * MCP23S17 model.
+ * Only the port A registers and IOCON sequential/byte mode matter here.
+ * With BANK=0, sequential mode walks all the registers and wraps from OLATB to IODIRA,
+ * byte mode toggles between the A/B register of a pair.
+ */
+#ifdef GLCD_BITSHIFT_COMMS
+
+static uint8_t glcdsim_McpRead(uint8_t reg)
+{
+	if(reg == GPIOA)
+	{
+		uint8_t dir = glcdsim_mcpregs[IODIRA];
+		uint8_t in = glcdsim_Bus() ^ glcdsim_mcpregs[IPOLA];
+		return((in & dir) | (glcdsim_mcpregs[OLATA] & ~dir));
+	}
+	return(glcdsim_mcpregs[reg]);
+}
+
+static void glcdsim_McpWrite(uint8_t reg, uint8_t data)
+{
+	if(reg == GPIOA)
+		reg = OLATA;
+	if(reg == GPIOB)
+		reg = OLATB;
+	if(reg == IOCON + 1)
+		reg = IOCON;
+
+	glcdsim_mcpregs[reg] = data;
+
+	/*
+	 * port A is wired to the glcd data lines
+	 */
+	glcdsim_hostdrv = ~glcdsim_mcpregs[IODIRA];
+	glcdsim_hostdata = glcdsim_mcpregs[OLATA];
+}
+
+void glcdsim_SpiSelect(uint8_t level)
+{
+	if(!level && glcdsim_ss)
+	{
+		glcdsim_spistate = 0;
+		glcdsim_stats.spi++;
+	}
+	glcdsim_ss = level;
+}
+
+uint8_t glcdsim_SpiTransfer(uint8_t data)
+{
+uint8_t rval = 0;
+
+	glcdsim_Tick(GLCDSIM_tSPIBYTE);
+	glcdsim_stats.spibytes++;
+
+	if(glcdsim_ss)	// not selected
+		return(0xff);
+
+	switch(glcdsim_spistate)
+	{
+	case 0:
+		glcdsim_spiop = data;
+		glcdsim_spistate++;
+		break;
+	case 1:
+		glcdsim_spiaddr = data % (OLATB+1);
+		glcdsim_spistate++;
+		break;
+	default:
+		if(glcdsim_spiop & 1)
+			rval = glcdsim_McpRead(glcdsim_spiaddr);
+		else
+			glcdsim_McpWrite(glcdsim_spiaddr, data);
+
+		if(glcdsim_mcpregs[IOCON] & 0x20)	// SEQOP set, byte mode
+			glcdsim_spiaddr ^= 1;
+		else
+			glcdsim_spiaddr = (glcdsim_spiaddr + 1) % (OLATB+1);
+		break;
+	}
+	return(rval);
+}
+
+#else
+
+void glcdsim_SpiSelect(uint8_t level) {}
+uint8_t glcdsim_SpiTransfer(uint8_t data) { return(0xff); }
+
+#endif
+
+/*
+ * Route the control lines to another module.
+ * This costs a pin write, like it would on real hardware.
+ * The inspection functions below look at the selected module.
+ */
+void glcdsim_SelectDisplay(uint8_t display)
+{
+	glcdsim_Tick(GLCDSIM_tIO);
+	glcdsim_display = display % GLCDSIM_DISPLAYS;
+}
+
+/*
+ * Change the controller busy time.
+ * Used to simulate a module that is slower than the datasheet
+ * to check code that does not poll the busy status.
+ * It stays in effect until changed again, glcdsim_Reset() does not restore it.
+ */
+void glcdsim_SetBusyTime(uint32_t ns)
+{
+	glcdsim_tbusy = ns;
+}
+
+/*
+ * simulator control and inspection
+ */
+
+void glcdsim_ClearStats(void)
+{
+	memset(&glcdsim_stats, 0, sizeof(glcdsim_stats));
+}
+
+void glcdsim_Reset(void)
+{
+	memset(glcdsim_chip, 0, sizeof(glcdsim_chip));
+	memset(glcdsim_pins, 0, sizeof(glcdsim_pins));
+	glcdsim_clock = 0;
+	glcdsim_display = 0;
+	glcdsim_lcddrive = 0;
+	glcdsim_hostdrv = 0;
+	glcdsim_hostdata = 0;
+
+#ifdef GLCD_BITSHIFT_COMMS
+	memset(glcdsim_mcpregs, 0, sizeof(glcdsim_mcpregs));
+	glcdsim_mcpregs[IODIRA] = 0xff;
+	glcdsim_mcpregs[IODIRB] = 0xff;
+	glcdsim_ss = 1;
+	glcdsim_pins[SS] = HIGH;
+#endif
+	glcdsim_ClearStats();
+}
+
+uint64_t glcdsim_BusTime(void)
+{
+uint64_t ns = 0;
+
+	for(uint8_t i = 0; i < GLCDSIM_NCYCLES; i++)
+		ns += glcdsim_stats.ns[i];
+	return(ns);
+}
+
+uint64_t glcdsim_Clock(void)
+{
+	return(glcdsim_clock);
+}
+
+uint8_t glcdsim_ReadRAM(uint8_t chip, uint8_t page, uint8_t col)
+{
+	return(glcdsim_chip[glcdsim_display][chip].ram[page % GLCDSIM_PAGES][col % GLCDSIM_COLS]);
+}
+
+uint8_t glcdsim_GetPixel(uint8_t x, uint8_t y)
+{
+uint8_t chip, col;
+
+	if(x >= DISPLAY_WIDTH || y >= DISPLAY_HEIGHT)
+		return(0);
+
+	chip = glcd_DevXYval2Chip(x, y);
+	col = glcd_DevXval2ChipCol(x);
+	return((glcdsim_ReadRAM(chip, (y % CHIP_HEIGHT)/8, col) >> (y & 7)) & 1);
+}
+
+uint32_t glcdsim_Checksum(void)
+{
+uint32_t hash = 2166136261UL; // FNV-1a
+
+	for(uint8_t y = 0; y < DISPLAY_HEIGHT; y += 8)
+	{
+		for(uint8_t x = 0; x < DISPLAY_WIDTH; x++)
+		{
+			uint8_t chip = glcd_DevXYval2Chip(x, y);
+			uint8_t col = glcd_DevXval2ChipCol(x);
+
+			hash ^= glcdsim_ReadRAM(chip, (y % CHIP_HEIGHT)/8, col);
+			hash *= 16777619UL;
+		}
+	}
+	return(hash);
+}
@@ -0,0 +1,50 @@
+/*
+ * Arduino.h - minimal Arduino core for building the glcd library on a host
+ *
+ * Only what the glcd library and the simulator harness use is here.
+ * Pin i/o is routed to the simulated glcd module (see include/glcd_sim.h).
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT  0x0
+#define OUTPUT 0x1
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define SS   10
+#define MOSI 11
+#define MISO 12
+#define SCK  13
+
+#ifndef _BV
+#define _BV(bit) (1 << (bit))
+#endif
+
+typedef uint8_t boolean;
+typedef uint8_t byte;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+unsigned long millis(void);
+unsigned long micros(void);
+
+#include <avr/pgmspace.h>
+#include "WString.h"
+#include "Print.h"
+
+#endif
@@ -0,0 +1,97 @@
+/*
+ * MCP23S17.h - host version of the MCP23S17 library used by GLCD_BITSHIFT_COMMS
+ *
+ * Register defines and the byte/word API match the Arduino MCP23S17 library,
+ * transactions go over the host SPI library to the simulated expander.
+ */
+
+#ifndef MCP23S17_h
+#define MCP23S17_h
+
+#include <SPI.h>
+
+// register addresses, IOCON.BANK = 0
+#define    IODIRA    (0x00)
+#define    IODIRB    (0x01)
+#define    IPOLA     (0x02)
+#define    IPOLB     (0x03)
+#define    GPINTENA  (0x04)
+#define    GPINTENB  (0x05)
+#define    DEFVALA   (0x06)
+#define    DEFVALB   (0x07)
+#define    INTCONA   (0x08)
+#define    INTCONB   (0x09)
+#define    IOCON     (0x0A)
+#define    GPPUA     (0x0C)
+#define    GPPUB     (0x0D)
+#define    INTFA     (0x0E)
+#define    INTFB     (0x0F)
+#define    INTCAPA   (0x10)
+#define    INTCAPB   (0x11)
+#define    GPIOA     (0x12)
+#define    GPIOB     (0x13)
+#define    OLATA     (0x14)
+#define    OLATB     (0x15)
+
+#define    ADDR_ENABLE   (0b00001000)
+#define    OPCODEW       (0b01000000)
+#define    OPCODER       (0b01000001)
+
+class MCP
+{
+  public:
+	MCP(uint8_t address) : _address(address)
+	{
+		SPI.begin();
+		byteWrite(IOCON, ADDR_ENABLE);
+	}
+
+	void byteWrite(uint8_t reg, uint8_t value)
+	{
+		::digitalWrite(SS, LOW);
+		SPI.transfer(OPCODEW | (_address << 1));
+		SPI.transfer(reg);
+		SPI.transfer(value);
+		::digitalWrite(SS, HIGH);
+	}
+
+	void wordWrite(uint8_t reg, unsigned int word)
+	{
+		::digitalWrite(SS, LOW);
+		SPI.transfer(OPCODEW | (_address << 1));
+		SPI.transfer(reg);
+		SPI.transfer((uint8_t) word);
+		SPI.transfer((uint8_t) (word >> 8));
+		::digitalWrite(SS, HIGH);
+	}
+
+	uint8_t byteRead(uint8_t reg)
+	{
+	uint8_t value;
+
+		::digitalWrite(SS, LOW);
+		SPI.transfer(OPCODER | (_address << 1));
+		SPI.transfer(reg);
+		value = SPI.transfer(0x00);
+		::digitalWrite(SS, HIGH);
+		return value;
+	}
+
+	unsigned int wordRead(uint8_t reg)
+	{
+	unsigned int value;
+
+		::digitalWrite(SS, LOW);
+		SPI.transfer(OPCODER | (_address << 1));
+		SPI.transfer(reg);
+		value = SPI.transfer(0x00);
+		value |= SPI.transfer(0x00) << 8;
+		::digitalWrite(SS, HIGH);
+		return value;
+	}
+
+  private:
+	uint8_t _address;
+};
+
+#endif
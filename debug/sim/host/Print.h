@@ -0,0 +1,40 @@
+/*
+ * Print.h - minimal host version of the Arduino Print class
+ */
+
+#ifndef Print_h
+#define Print_h
+
+#include <inttypes.h>
+#include <stddef.h>
+#include "WString.h"
+
+#ifndef DEC
+#define DEC 10
+#endif
+
+class Print
+{
+  public:
+	virtual size_t write(uint8_t) = 0;
+	size_t write(const char *str);
+	virtual size_t write(const uint8_t *buffer, size_t size);
+
+	size_t print(const String &s);
+	size_t print(const char str[]);
+	size_t print(char c);
+	size_t print(unsigned char n, int base = DEC);
+	size_t print(int n, int base = DEC);
+	size_t print(unsigned int n, int base = DEC);
+	size_t print(long n, int base = DEC);
+	size_t print(unsigned long n, int base = DEC);
+	size_t print(double n, int digits = 2);
+
+	size_t println(void);
+	size_t println(const char str[]);
+	size_t println(long n, int base = DEC);
+  private:
+	size_t printNumber(unsigned long n, uint8_t base);
+};
+
+#endif
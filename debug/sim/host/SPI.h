@@ -0,0 +1,36 @@
+/*
+ * SPI.h - host version of the Arduino SPI library
+ *
+ * Bytes are handed to the simulated MCP23S17 (see include/glcd_sim.h)
+ */
+
+#ifndef _SPI_H_INCLUDED
+#define _SPI_H_INCLUDED
+
+#include "Arduino.h"
+#include "include/glcd_sim.h"
+
+#define SPI_CLOCK_DIV4 0x00
+#define SPI_CLOCK_DIV16 0x01
+#define SPI_CLOCK_DIV64 0x02
+#define SPI_CLOCK_DIV128 0x03
+#define SPI_CLOCK_DIV2 0x04
+#define SPI_CLOCK_DIV8 0x05
+#define SPI_CLOCK_DIV32 0x06
+
+#define SPI_MODE0 0x00
+
+class SPIClass
+{
+  public:
+	inline static uint8_t transfer(uint8_t data) { return glcdsim_SpiTransfer(data); }
+	static void begin(void) { pinMode(SS, OUTPUT); digitalWrite(SS, HIGH); }
+	static void end(void) {}
+	static void setBitOrder(uint8_t) {}
+	static void setDataMode(uint8_t) {}
+	static void setClockDivider(uint8_t) {}
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,21 @@
+/*
+ * WString.h - minimal host version of the Arduino String class
+ */
+
+#ifndef String_h
+#define String_h
+
+#include <string>
+
+class String
+{
+  public:
+	String(const char *cstr = "") : buffer(cstr) {}
+	unsigned int length(void) const { return buffer.length(); }
+	char operator [] (unsigned int index) const { return buffer[index]; }
+	const char *c_str(void) const { return buffer.c_str(); }
+  private:
+	std::string buffer;
+};
+
+#endif
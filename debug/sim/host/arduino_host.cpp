@@ -0,0 +1,160 @@
+/*
+ * arduino_host.cpp - minimal Arduino core for building the glcd library on a host
+ *
+ * Pin writes go to the simulated glcd module and time is simulated time.
+ */
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "include/glcd_sim.h"
+
+SPIClass SPI;
+
+void pinMode(uint8_t, uint8_t)
+{
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+	glcdsim_WritePin(pin, val);
+}
+
+int digitalRead(uint8_t)
+{
+	return(LOW);
+}
+
+void delay(unsigned long ms)
+{
+	glcdsim_DelayMilliseconds(ms);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	glcdsim_Delay(us * 1000UL);
+}
+
+unsigned long millis(void)
+{
+	return(glcdsim_Clock() / 1000000);
+}
+
+unsigned long micros(void)
+{
+	return(glcdsim_Clock() / 1000);
+}
+
+/*
+ * Print
+ */
+
+size_t Print::write(const char *str)
+{
+	return(write((const uint8_t *) str, strlen(str)));
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+size_t n = 0;
+
+	while(size--)
+		n += write(*buffer++);
+	return(n);
+}
+
+size_t Print::print(const String &s)
+{
+	return(write(s.c_str()));
+}
+
+size_t Print::print(const char str[])
+{
+	return(write(str));
+}
+
+size_t Print::print(char c)
+{
+	return(write((uint8_t) c));
+}
+
+size_t Print::print(unsigned char n, int base)
+{
+	return(print((unsigned long) n, base));
+}
+
+size_t Print::print(int n, int base)
+{
+	return(print((long) n, base));
+}
+
+size_t Print::print(unsigned int n, int base)
+{
+	return(print((unsigned long) n, base));
+}
+
+size_t Print::print(long n, int base)
+{
+	if(n < 0 && base == DEC)
+		return(print('-') + printNumber(-n, base));
+	return(printNumber(n, base));
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+	return(printNumber(n, base));
+}
+
+size_t Print::print(double n, int digits)
+{
+size_t len = 0;
+
+	if(n < 0.0)
+	{
+		len += print('-');
+		n = -n;
+	}
+	unsigned long whole = (unsigned long) n;
+	len += print(whole);
+	if(digits > 0)
+		len += print('.');
+	for(n -= whole; digits-- > 0; )
+	{
+		n *= 10.0;
+		len += print((int) n % 10);
+	}
+	return(len);
+}
+
+size_t Print::println(void)
+{
+	return(write('\n'));
+}
+
+size_t Print::println(const char str[])
+{
+	return(print(str) + println());
+}
+
+size_t Print::println(long n, int base)
+{
+	return(print(n, base) + println());
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base)
+{
+char buf[8 * sizeof(long) + 1];
+char *str = &buf[sizeof(buf) - 1];
+
+	*str = '\0';
+	if(base < 2)
+		base = 10;
+	do
+	{
+		unsigned long m = n;
+		n /= base;
+		char c = m - base * n;
+		*--str = c < 10 ? c + '0' : c + 'A' - 10;
+	} while(n);
+
+	return(write(str));
+}
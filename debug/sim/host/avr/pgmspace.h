@@ -0,0 +1,24 @@
+/*
+ * avr/pgmspace.h - host version, program memory is just memory
+ */
+
+#ifndef __PGMSPACE_H_
+#define __PGMSPACE_H_
+
+#include <inttypes.h>
+
+/*
+ * The font and bitmap headers define static tables that a sketch
+ * may not use. On the AVR those are simply left out of flash.
+ */
+#define PROGMEM __attribute__((unused))
+#define PSTR(s) (s)
+#define PGM_P const char *
+
+typedef char prog_char;
+typedef uint8_t prog_uchar;
+
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+
+#endif
@@ -0,0 +1,571 @@
+/*
+ * simbench.cpp - glcd rendering cost benchmark on the simulated module
+ *
+ * vi:ts=4
+ *
+ * Runs a fixed set of drawing operations through the unmodified library
+ * and reports, for each one, the bus cycles by type, busy polls,
+ * SPI transactions and the total bus time along with a checksum of the
+ * resulting module RAM.
+ *
+ * The output is deterministic so it can be diffed against a previous run
+ * to catch both rendering changes (checksum) and cost regressions.
+ *
+ * usage: simbench [-v]
+ *		-v	dump the module RAM as ascii art after each test
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "glcd.h"
+#include "include/glcd_sim.h"
+#include "fonts/allFonts.h"
+#include "bitmaps/allBitmaps.h"
+
+static int verbose;
+
+#if GLCDSIM_DISPLAYS > 1
+glcd_DeviceState display2State(1);
+glcd GLCD2(display2State);
+gText textArea2(GLCD2, 0, 0, DISPLAY_WIDTH-1, DISPLAY_HEIGHT-1);
+#endif
+
+static void dump(void)
+{
+	for(uint8_t y = 0; y < DISPLAY_HEIGHT; y++)
+	{
+		for(uint8_t x = 0; x < DISPLAY_WIDTH; x++)
+			putchar(glcdsim_GetPixel(x, y) ? '#' : '.');
+		putchar('\n');
+	}
+}
+
+/*
+ * convert a glcd format bitmap to the x11 xbm format used by DrawBitmapXBM()
+ */
+static void makeXBM(Image_t bitmap, uint8_t *xbm)
+{
+	uint8_t width = bitmap[0];
+	uint8_t height = bitmap[1];
+	uint8_t stride = (width + 7) / 8;
+
+	xbm[0] = width;
+	xbm[1] = height;
+	memset(xbm + 2, 0, stride * height);
+	for(uint8_t y = 0; y < height; y++)
+		for(uint8_t x = 0; x < width; x++)
+			if(bitmap[2 + (y / 8) * width + x] & (1 << (y & 7)))
+				xbm[2 + y * stride + x / 8] |= 1 << (x & 7);
+}
+
+/*
+ * run length encode a glcd format bitmap for DrawBitmapRLE() the same way the
+ * bitmap tool does. If prev is given, the bytes that are the same in prev are skipped.
+ * Returns the size of the encoded bitmap.
+ */
+static unsigned makeRLE(Image_t bitmap, Image_t prev, uint8_t *rle)
+{
+	unsigned count = bitmap[0] * ((bitmap[1] + 7) / 8);
+	const uint8_t *data = bitmap + 2;
+	uint8_t *p = rle;
+	unsigned i, n;
+
+#define SAME(j) (prev && prev[2 + (j)] == data[j])
+	*p++ = bitmap[0];
+	*p++ = bitmap[1];
+	for(i = 0; i < count; i += n)
+	{
+		for(n = 1; i + n < count && n < 64 && SAME(i) && SAME(i + n); n++)
+			;
+		if(SAME(i))
+		{
+			*p++ = 0xc0 + n - 1;
+			continue;
+		}
+		for(n = 1; i + n < count && n < 64 && data[i + n] == data[i] && !SAME(i + n); n++)
+			;
+		if(n >= 3)
+		{
+			*p++ = 0x80 + n - 1;
+			*p++ = data[i];
+			continue;
+		}
+		for(n = 1; i + n < count && n < 128 && !SAME(i + n) &&
+			!(i + n + 2 < count && data[i + n] == data[i + n + 1] && data[i + n] == data[i + n + 2]); n++)
+			;
+		*p++ = n - 1;
+		memcpy(p, data + i, n);
+		p += n;
+	}
+#undef SAME
+	return(p - rle);
+}
+
+/*
+ * make animation data for glcd_Animation from count glcd format bitmaps
+ * the same size, the same way the bitmap tool does.
+ * Returns the size of the animation data.
+ */
+static unsigned makeAnim(Image_t *frames, uint8_t count, uint16_t interval, uint8_t *anim)
+{
+	uint8_t *p = anim + 5;
+	unsigned len;
+
+	anim[0] = frames[0][0];
+	anim[1] = frames[0][1];
+	anim[2] = count;
+	anim[3] = interval & 0xff;
+	anim[4] = interval >> 8;
+	for(uint8_t f = 0; f <= count; f++)
+	{
+		len = makeRLE(frames[f % count], f ? frames[f - 1] : 0, p) - 2;	// the size replaces width and height
+		p[0] = len & 0xff;
+		p[1] = len >> 8;
+		p += 2 + len;
+	}
+	return(p - anim);
+}
+
+static void report(const char *name)
+{
+	printf("%-22s %6u %6u %6u %6u %7u %6u %5u %10.1f  %08x\n", name,
+		glcdsim_stats.cycles[GLCDSIM_CMD],
+		glcdsim_stats.cycles[GLCDSIM_WRITE],
+		glcdsim_stats.cycles[GLCDSIM_READ],
+		glcdsim_stats.cycles[GLCDSIM_STATUS],
+		glcdsim_stats.polls,
+		glcdsim_stats.spi,
+		glcdsim_stats.overruns,
+		glcdsim_BusTime() / 1000.0,
+		glcdsim_Checksum());
+
+	if(verbose)
+		dump();
+	glcdsim_ClearStats();
+}
+
+int main(int argc, char **argv)
+{
+	int status = 0;
+
+	if(argc > 1 && !strcmp(argv[1], "-v"))
+		verbose = 1;
+
+	printf("panel: %s %ux%u, %u chips%s\n", GLCDSIM_PANELNAME, DISPLAY_WIDTH, DISPLAY_HEIGHT,
+		glcd_CHIP_COUNT,
+#ifdef GLCD_BITSHIFT_COMMS
+		", MCP23S17 data port"
+#else
+		""
+#endif
+		);
+	printf("%-22s %6s %6s %6s %6s %7s %6s %5s %10s  %s\n", "test",
+		"cmd", "write", "read", "status", "polls", "spi", "ovr", "bus(us)", "checksum");
+
+	glcdsim_Reset();
+
+	GLCD.Init(NON_INVERTED);
+	report("Init");
+
+	GLCD.ClearScreen(BLACK);
+	report("ClearScreen");
+
+	GLCD.ClearScreen(WHITE);
+	GLCD.SetDot(10, 10, BLACK);
+	report("SetDot");
+
+	GLCD.DrawLine(0, 5, GLCD.Right, 40);
+	report("DrawLine shallow");
+
+	GLCD.DrawLine(20, 0, 40, GLCD.Bottom);
+	report("DrawLine steep");
+
+	GLCD.DrawRect(50, 3, 60, 50);
+	report("DrawRect");
+
+	GLCD.FillRect(60, 13, 40, 30);
+	report("FillRect");
+
+	GLCD.InvertRect(5, 5, 100, 50);
+	report("InvertRect");
+
+	GLCD.ClearScreen();
+	GLCD.DrawCircle(GLCD.CenterX, GLCD.CenterY, 25);
+	report("DrawCircle");
+
+	GLCD.DrawRoundRect(5, 5, 80, 40, 8);
+	report("DrawRoundRect");
+
+	GLCD.FillCircle(GLCD.CenterX, GLCD.CenterY, 20);
+	report("FillCircle");
+
+	GLCD.FillEllipse(GLCD.CenterX, GLCD.CenterY, 70, 25, WHITE);
+	report("FillEllipse");
+
+	GLCD.ClearScreen();
+	GLCD.DrawBitmap(ArduinoIcon64x64, 0, 0);
+	report("DrawBitmap aligned");
+
+	GLCD.DrawBitmap(ArduinoIcon64x32, 70, 5);
+	report("DrawBitmap unaligned");
+
+	/*
+	 * the same image again as a sprite, then combined with what is there
+	 */
+	GLCD.DrawSprite(ArduinoIcon64x32, 70, 5);
+	report("DrawSprite opaque");
+
+	GLCD.DrawSprite(ArduinoIcon64x32, 40, 21, SPRITE_XOR);
+	report("DrawSprite xor");
+
+	GLCD.DrawSprite(ArduinoIcon64x32, 100, 29, SPRITE_MASKED, ArduinoIcon64x32);
+	report("DrawSprite masked");
+
+	/*
+	 * a sprite moving down a pixel at a time, from the bitmap and then
+	 * from pre-shifted copies. The bus cost is the same, the copies save
+	 * the shifting on the cpu.
+	 */
+	{
+		static uint8_t copies[8 * GLCD_SPRITE_COPYSIZE(32, 32, false)];
+		glcd_SpriteCache icon(ArduinoIcon32x32, copies, sizeof(copies));
+
+		GLCD.ClearScreen();
+		glcdsim_ClearStats();
+		for(uint8_t y = 0; y < 32; y++)
+			GLCD.DrawSprite(ArduinoIcon32x32, 80, y);
+		report("DrawSprite frames");
+
+		GLCD.ClearScreen();
+		glcdsim_ClearStats();
+		for(uint8_t y = 0; y < 32; y++)
+			GLCD.DrawSprite(icon, 80, y);
+		report("DrawSprite cached");
+	}
+
+	/*
+	 * the bitmaps above converted to xbm, they should draw
+	 * the same as DrawBitmap aligned and unaligned
+	 */
+	{
+		static uint8_t xbm64x64[2 + 8 * 64], xbm64x32[2 + 8 * 32];
+
+		makeXBM(ArduinoIcon64x64, xbm64x64);
+		makeXBM(ArduinoIcon64x32, xbm64x32);
+		GLCD.ClearScreen();
+		glcdsim_ClearStats();
+		GLCD.DrawBitmapXBM(xbm64x64, 0, 0);
+		report("DrawXBM aligned");
+
+		GLCD.DrawBitmapXBM(xbm64x32, 70, 5);
+		report("DrawXBM unaligned");
+	}
+
+	/*
+	 * the same bitmaps run length encoded, then the 64x32 one changed
+	 * to have the 32x32 icon in the middle drawn as only the bytes that changed.
+	 */
+	{
+		static uint8_t rle64x64[2 * sizeof(ArduinoIcon64x64)], rle64x32[2 * sizeof(ArduinoIcon64x32)];
+		static uint8_t changed[sizeof(ArduinoIcon64x32)], delta[2 * sizeof(ArduinoIcon64x32)];
+
+		makeRLE(ArduinoIcon64x64, 0, rle64x64);
+		makeRLE(ArduinoIcon64x32, 0, rle64x32);
+		memcpy(changed, ArduinoIcon64x32, sizeof(changed));
+		for(uint8_t page = 0; page < 4; page++)
+			memcpy(changed + 2 + page * 64 + 16, ArduinoIcon32x32 + 2 + page * 32, 32);
+		makeRLE(changed, ArduinoIcon64x32, delta);
+
+		GLCD.ClearScreen();
+		glcdsim_ClearStats();
+		GLCD.DrawBitmapRLE(rle64x64, 0, 0);
+		report("DrawRLE aligned");
+
+		GLCD.DrawBitmapRLE(rle64x32, 70, 5);
+		report("DrawRLE unaligned");
+
+		GLCD.DrawBitmapRLE(delta, 70, 5);
+		report("DrawRLE delta");
+	}
+
+	/*
+	 * 16 frames of the 32x32 icon moving across a 96x32 area drawn as bitmaps,
+	 * then played as an animation that only writes what changes.
+	 */
+	{
+		static uint8_t frames[16][2 + 96 * 4], anim[16 * 2 * sizeof(frames[0])];
+		Image_t framelist[16];
+		uint8_t drawn;
+
+		for(uint8_t f = 0; f < 16; f++)
+		{
+			memset(frames[f], 0, sizeof(frames[f]));
+			frames[f][0] = 96;
+			frames[f][1] = 32;
+			for(uint8_t page = 0; page < 4; page++)
+				memcpy(frames[f] + 2 + page * 96 + f * 4, ArduinoIcon32x32 + 2 + page * 32, 32);
+			framelist[f] = frames[f];
+		}
+		makeAnim(framelist, 16, 50, anim);
+
+		GLCD.ClearScreen();
+		glcdsim_ClearStats();
+		for(uint8_t f = 0; f < 16; f++)
+			GLCD.DrawBitmap(frames[f], 10, 16);
+		report("Animation bitmaps");
+
+		glcd_Animation mover(anim, 10, 16);
+		GLCD.ClearScreen();
+		glcdsim_ClearStats();
+		for(drawn = 0; drawn < 16; )
+		{
+			if(GLCD.PlayAnimation(mover))
+				drawn++;
+			else
+				delay(1);
+		}
+		report("Animation played");
+	}
+
+	GLCD.ClearScreen();
+	GLCD.SelectFont(System5x7);
+	GLCD.CursorToXY(0, 8);
+	GLCD.Puts("0123456789 0123456789 0123");
+	report("Puts 5x7 aligned");
+
+	GLCD.CursorToXY(0, 19);
+	GLCD.Puts("0123456789 0123456789 0123");
+	report("Puts 5x7 unaligned");
+
+	GLCD.SelectFont(Arial_14);
+	GLCD.CursorToXY(0, 32);
+	GLCD.Puts("the quick brown fox jumps");
+	report("Puts Arial14");
+
+	GLCD.SelectFont(fixednums8x16);
+	GLCD.CursorToXY(0, 48);
+	GLCD.Puts("1234567890");
+	report("Puts 8x16 digits");
+
+	/*
+	 * a dashboard of numbers on page aligned rows redrawn in place
+	 */
+	GLCD.ClearScreen();
+	glcdsim_ClearStats();
+	for(uint8_t r = 0; r < 4; r++)
+	{
+		GLCD.SelectFont(Arial_14);
+		for(uint8_t y = 0; y < 48; y += 16)
+		{
+			GLCD.CursorToXY(0, y);
+			GLCD.Puts(r & 1 ? "1234 5678 90" : "9087 6543 21");
+		}
+		GLCD.SelectFont(Verdana24);
+		GLCD.CursorToXY(100, 16);
+		GLCD.Puts(r & 1 ? "1234" : "5678");
+	}
+	report("Puts dashboard");
+
+	GLCD.SelectFont(System5x7);
+	GLCD.CursorToXY(0, 0);
+	for(uint8_t i = 0; i < 12; i++)
+		GLCD.Puts("scrolling text line\n");
+	report("Puts scroll");
+
+	/*
+	 * a scene drawn into a small viewport, most of it is outside
+	 * the clip area and skipped
+	 */
+	GLCD.ClearScreen();
+	glcdsim_ClearStats();
+	GLCD.PushClip(8, 8, 71, 39);
+	for(uint8_t i = 0; i < 8; i++)
+		GLCD.DrawLine(0, i*8, GLCD.Right, GLCD.Bottom - i*8);
+	GLCD.DrawBitmap(ArduinoIcon64x64, 40, 0);
+	GLCD.SelectFont(System5x7);
+	GLCD.CursorToXY(0, 20);
+	GLCD.Puts("clipped to a viewport");
+	GLCD.PopClip();
+	report("Clipped viewport");
+
+	/*
+	 * objects hanging off the edges of the display
+	 */
+	GLCD.ClearScreen();
+	glcdsim_ClearStats();
+	GLCD.DrawBitmap(ArduinoIcon64x64, -20, -24);
+	GLCD.DrawBitmap(ArduinoIcon64x64, GLCD.Right - 40, 30);
+	GLCD.FillCircle(GLCD.CenterX, -10, 30);
+	GLCD.DrawCircle(-5, GLCD.Bottom, 40);
+	GLCD.DrawLine(-100, -50, GLCD.Right + 100, GLCD.Bottom + 50);
+	report("Off the edges");
+
+	/*
+	 * clip areas entirely off each edge of the display are empty,
+	 * nothing is drawn inside them. Past 255 the coordinates
+	 * would wrap onto the display if they were not clamped.
+	 */
+	{
+		static const int16_t off[4][4] = {
+			{ -50, 0, -10, DISPLAY_HEIGHT-1 },
+			{ 300, 0, 400, DISPLAY_HEIGHT-1 },
+			{ 0, -50, DISPLAY_WIDTH-1, -10 },
+			{ 0, 300, DISPLAY_WIDTH-1, 400 },
+		};
+		unsigned drawn = 0;
+
+		GLCD.ClearScreen();
+		glcdsim_ClearStats();
+		GLCD.SelectFont(System5x7);
+		for(uint8_t i = 0; i < 4; i++)
+		{
+			GLCD.PushClip(off[i][0], off[i][1], off[i][2], off[i][3]);
+			GLCD.FillRect(0, 0, GLCD.Right, GLCD.Bottom);
+			GLCD.DrawLine(0, 0, GLCD.Right, GLCD.Bottom);
+			GLCD.DrawBitmap(ArduinoIcon64x64, 0, 0);
+			GLCD.CursorToXY(0, 0);
+			GLCD.Puts("clipped");
+			GLCD.PopClip();
+		}
+		report("Clip off the display");
+		for(uint8_t y = 0; y < DISPLAY_HEIGHT; y++)
+			for(uint8_t x = 0; x < DISPLAY_WIDTH; x++)
+				drawn += glcdsim_GetPixel(x, y);
+		printf("  pixels drawn %u%s\n", drawn, drawn ? " FAILED" : "");
+		if(drawn)
+			status = 1;
+	}
+
+	/*
+	 * a long, nearly diagonal line with its start far off the display,
+	 * clipped a long way into it. k*deltay for the first step inside
+	 * the clip area is past 2^31. After k steps the line has moved
+	 * ceil((k*deltay - deltax/2) / deltax) rows.
+	 */
+	{
+		const int32_t x1 = -32768, y1 = -32767, x2 = 32767, y2 = 32733;
+		const int64_t dx = x2 - x1, dy = y2 - y1;
+		unsigned wrong = 0;
+		int64_t k, m;
+
+		GLCD.ClearScreen();
+		glcdsim_ClearStats();
+		GLCD.PushClip(60, 0, GLCD.Right, GLCD.Bottom);
+		GLCD.DrawLine(x1, y1, x2, y2);
+		GLCD.PopClip();
+		report("Long line clipped");
+		for(uint8_t x = 0; x < DISPLAY_WIDTH; x++)
+		{
+			k = x - x1;
+			m = k*dy > dx/2 ? (k*dy - dx/2 + dx - 1) / dx : 0;
+			for(uint8_t y = 0; y < DISPLAY_HEIGHT; y++)
+				wrong += glcdsim_GetPixel(x, y) != (x >= 60 && y == y1 + m);
+		}
+		printf("  pixels wrong %u%s\n", wrong, wrong ? " FAILED" : "");
+		if(wrong)
+			status = 1;
+	}
+
+	/*
+	 * the same full screen pattern written a byte at a time with WriteData(),
+	 * which goes through one chip after the other, and by page with
+	 * WriteDataBlock(), which interleaves the chips.
+	 */
+	{
+		uint8_t row[DISPLAY_WIDTH];
+
+		GLCD.ClearScreen();
+		glcdsim_ClearStats();
+		for(uint8_t page = 0; page < DISPLAY_HEIGHT/8; page++)
+		{
+			GLCD.GotoXY(0, page*8);
+			for(uint8_t x = 0; x < DISPLAY_WIDTH; x++)
+				GLCD.WriteData(x * 7 + page);
+		}
+		report("Screen WriteData");
+
+		GLCD.ClearScreen();
+		glcdsim_ClearStats();
+		for(uint8_t page = 0; page < DISPLAY_HEIGHT/8; page++)
+		{
+			for(uint8_t x = 0; x < DISPLAY_WIDTH; x++)
+				row[x] = x * 7 + page;
+			GLCD.GotoXY(0, page*8);
+			GLCD.WriteDataBlock(row, DISPLAY_WIDTH);
+		}
+		report("Screen WriteDataBlock");
+	}
+
+#ifdef GLCD_FRAMEBUFFER
+	/*
+	 * a frame drawn entirely in the frame buffer then flushed once
+	 */
+	GLCD.SetFlushMode(FLUSH_MANUAL);
+	GLCD.ClearScreen();
+	GLCD.DrawRect(0, 0, GLCD.Right, GLCD.Bottom);
+	GLCD.DrawCircle(GLCD.CenterX, GLCD.CenterY, 20);
+	GLCD.CursorToXY(4, 4);
+	GLCD.Puts("frame");
+	GLCD.Flush();
+	report("Frame manual flush");
+
+	GLCD.CursorToXY(4, 4);
+	GLCD.Puts("FRAME");
+	GLCD.Flush();
+	report("Frame small update");
+
+	GLCD.ClearScreen();
+	GLCD.CursorToXY(4, 4);
+	GLCD.Puts("FRAME");
+	GLCD.Flush();
+	report("Frame clear+text");
+	GLCD.SetFlushMode(FLUSH_AUTO);
+#endif
+
+#if GLCDSIM_DISPLAYS > 1
+	/*
+	 * the same text drawn a character at a time on two displays,
+	 * interleaved. Both must end up like Puts 5x7 aligned above.
+	 */
+	GLCD2.Init(NON_INVERTED);
+	GLCD.ClearScreen();
+	GLCD.SelectFont(System5x7);
+	GLCD.CursorToXY(0, 8);
+	textArea2.SelectFont(System5x7);
+	textArea2.CursorToXY(0, 8);
+	glcdsim_ClearStats();
+	for(const char *str = "0123456789 0123456789 0123"; *str; str++)
+	{
+		GLCD.PutChar(*str);
+		textArea2.PutChar(*str);
+	}
+	report("Two displays");
+	for(uint8_t display = 0; display < 2; display++)
+	{
+		glcdsim_SelectDisplay(display);
+		printf("  display %u checksum %08x\n", display, glcdsim_Checksum());
+	}
+	glcdsim_SelectDisplay(0);
+#endif
+
+#ifdef GLCD_TIMED_IO
+	/*
+	 * a module much slower than the datasheet worst case.
+	 * Init() must find that waiting out GLCD_tBUSY is not enough
+	 * and stay with busy polling, the checksums must match the
+	 * ClearScreen and DrawBitmap aligned tests above.
+	 */
+	glcdsim_SetBusyTime(GLCDSIM_tBUSY * 10);
+	GLCD.Init(NON_INVERTED);
+	GLCD.ClearScreen(BLACK);
+	report("Slow module Init");
+
+	GLCD.ClearScreen();
+	GLCD.DrawBitmap(ArduinoIcon64x64, 0, 0);
+	report("Slow module bitmap");
+	glcdsim_SetBusyTime(GLCDSIM_tBUSY);
+#endif
+
+	return(status);
+}
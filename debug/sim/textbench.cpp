@@ -0,0 +1,124 @@
+/*
+ * textbench.cpp - glcd text throughput benchmark on the simulated module
+ *
+ * vi:ts=4
+ *
+ * Prints the same lines of text over and over in each font through the
+ * unmodified library and reports, per character printed, the font data
+ * reads (FontRead() calls), the bus time on the simulated module and the
+ * host cpu time.
+ * The lines are printed a character at a time with PutChar() and then
+ * a line at a time with Puts().
+ *
+ * The font reads and bus time are deterministic. The host time is only
+ * a rough guide to the cpu cost of the library code, since it includes
+ * the module model, but it moves with the font reads.
+ *
+ * usage: textbench [repeats]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "glcd.h"
+#include "include/glcd_sim.h"
+#include "fonts/allFonts.h"
+
+static unsigned long fontReads;
+
+static uint8_t countingRead(const uint8_t *p)
+{
+	fontReads++;
+	return(ReadPgmData(p));
+}
+
+static double cpuSeconds(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return(ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+/*
+ * print lines in font a line at a time from the top of the display
+ * repeats times and report the cost per character
+ */
+static void bench(const char *name, Font_t font, const char **lines, int repeats, bool puts)
+{
+	unsigned long chars = 0;
+	uint8_t lineHeight;
+	double start;
+
+	GLCD.ClearScreen();
+	GLCD.SelectFont(font, BLACK, countingRead);
+	lineHeight = font[FONT_HEIGHT] + 1;
+	fontReads = 0;
+	glcdsim_ClearStats();
+	start = cpuSeconds();
+	for(int r = 0; r < repeats; r++)
+	{
+		for(uint8_t i = 0; lines[i] && (i + 1) * lineHeight <= DISPLAY_HEIGHT; i++)
+		{
+			GLCD.CursorToXY(0, i * lineHeight);
+			if(puts)
+			{
+				GLCD.Puts((char *)lines[i]);
+				chars += strlen(lines[i]);
+			}
+			else
+			{
+				for(const char *s = lines[i]; *s; s++)
+					chars += GLCD.PutChar(*s);
+			}
+		}
+	}
+	printf("%-20s %8lu %10.1f %10.1f %11.0f  %08x\n", name, chars,
+		(double)fontReads / chars,
+		glcdsim_BusTime() / 1000.0 / chars,
+		(cpuSeconds() - start) * 1e9 / chars,
+		glcdsim_Checksum());
+}
+
+int main(int argc, char **argv)
+{
+	static const char *text[] = {
+		"the quick brown fox",
+		"jumps over the lazy dog",
+		"Pack my box with five",
+		"dozen liquor jugs.",
+		0
+	};
+	static const char *digits[] = {
+		"0123456789",
+		"9876543210",
+		0
+	};
+	int repeats = argc > 1 ? atoi(argv[1]) : 100;
+
+	printf("panel: %s %ux%u%s", GLCDSIM_PANELNAME, DISPLAY_WIDTH, DISPLAY_HEIGHT,
+#ifdef GLCD_FONT_INDEX
+		", font index\n"
+#else
+		"\n"
+#endif
+		);
+
+	glcdsim_Reset();
+	GLCD.Init(NON_INVERTED);
+
+	for(int puts = 0; puts < 2; puts++)
+	{
+		printf("\n%-20s %8s %10s %10s %11s  %s\n", puts ? "font (Puts)" : "font (PutChar)",
+			"chars", "reads/ch", "bus(us)/ch", "host(ns)/ch", "checksum");
+		bench("System5x7", System5x7, text, repeats, puts);
+		bench("Arial14", Arial_14, text, repeats, puts);
+		bench("Arial_bold_14", Arial_bold_14, text, repeats, puts);
+		bench("Corsiva_12", Corsiva_12, text, repeats, puts);
+		bench("fixednums8x16", fixednums8x16, digits, repeats, puts);
+		bench("Verdana_digits_24", Verdana24, digits, repeats, puts);
+	}
+	return(0);
+}
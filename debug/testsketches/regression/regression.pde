@@ -73,8 +73,18 @@ void regression(void)
 	GLCD.SetPixels(0,0, 20,20, BLACK);
 	GLCD.SetPixels(uint8var, uint8var, uint8var, uint8var, BLACK);
 	uint8var = GLCD.ReadData();
+	GLCD.ReadDataBlock(&uint8var, 1);
 	GLCD.WriteData(0);
 	GLCD.WriteData(uint8var);
+	GLCD.WriteDataBlock(&uint8var, 1);
+	GLCD.WriteDataBlock((const uint8_t *)ArduinoIcon, 8, ReadPgmData, WHITE);
+
+	GLCD.BeginUpdate();
+	GLCD.EndUpdate();
+	GLCD.SetFlushMode(FLUSH_MANUAL);
+	GLCD.SetFlushMode(FLUSH_TIMED, 20);
+	GLCD.SetFlushMode(FLUSH_AUTO);
+	GLCD.Flush();
 
 	/*
 	 * Graphic Functions
@@ -99,26 +99,15 @@
 
 /*
  * Convert X & Y coordinates to chip values
- * The macros below assume that chips are either
- * horizontal (normal) or vertical.
- * Horizontal has never been tested and while close
- * the DevXval2ChipCol() macro is currently incorrect for
- * this configuration.
+ * The chips can be laid out horizontally (normal), vertically
+ * or both, say for something like a 128x128 with 64 pixels each.
  *
- * If a module does both say for something like a 128x128
- * with 64 pixels each, then the macros below will have
- * to be corrected to acccount for this.
- *
- * While it looks like espensive divides, it will
+ * glcd_Panel (see glcd_Panel.h) does the mapping with compile time constants.
+ * While it looks like expensive divides, it will
  * actually map to masking because chip widths/heights
  * on the ks0108 are powers of 2
  */
-#if CHIP_HEIGHT < DISPLAY_HEIGHT
-#define glcd_DevXYval2Chip(x,y) ((x/CHIP_WIDTH) + ((y/CHIP_HEIGHT) * (DISPLAY_HEIGHT/CHIP_HEIGHT)))
-#else
-#define glcd_DevXYval2Chip(x,y)		((x/CHIP_WIDTH))	
-#endif
-
-#define glcd_DevXval2ChipCol(x)		((x) % CHIP_WIDTH)
+#define glcd_DevXYval2Chip(x,y)		glcd_Panel::XYval2Chip(x, y)
+#define glcd_DevXval2ChipCol(x)		glcd_Panel::Xval2ChipCol(x)
 
 #endif //GLCD_PANEL_DEVICE_H
@@ -38,16 +38,67 @@ extern "C"
 
 //#define GLCD_OLD_FONTDRAW    // uncomment this define to get old font rendering (not recommended)
 
-	
-//extern glcd_Device GLCD; // this is the global GLCD instance, here upcast to the base glcd_Device class 
+static FontCallback	FontRead;               // font callback shared across all instances
+
+#ifdef GLCD_FONT_INDEX
+/*
+ * Where the glyph data of each character starts in the variable width font
+ * last drawn, so PutChar() does not have to add up the widths of all the
+ * characters before the one it draws.
+ * Like FontRead this is shared by all text areas. It is built the first time
+ * a variable width font is drawn after SelectFont(), or after another text area
+ * draws with a different font.
+ */
+static Font_t glcd_IndexedFont;
+static uint16_t glcd_FontIndex[GLCD_FONT_INDEX];	// sum of the widths of the characters before each one
+#endif
+
+#ifdef GLCD_GLYPH_CACHE
+/*
+ * The glyph data of the characters drawn most recently, with the residual bits
+ * of Thiele fonts already shifted into place, so drawing them again does not
+ * read the font at all (see FindGlyph()).
+ * Like FontRead this is shared by all text areas and it holds glyphs of any font.
+ * It is emptied when SelectFont() changes the font callback.
+ */
+static struct
+{
+	Font_t font;		// 0 when the entry is empty
+	uint16_t index;		// offset of the glyph data in the font
+	uint8_t c;
+	uint8_t width;
+	uint8_t kind;		// FindGlyph() return value
+	uint8_t age;		// number of entries used since this one was
+	uint8_t data[GLCD_GLYPH_CACHE_SIZE];
+} glcd_GlyphCache[GLCD_GLYPH_CACHE];
+static FontCallback glcd_GlyphCacheRead;	// font callback the glyphs were read with
+
+/*
+ * make glyph cache entry e the most recently used one
+ */
+static void GlyphCacheUse(uint8_t e)
+{
+	for(uint8_t i = 0; i < GLCD_GLYPH_CACHE; i++)
+	{
+		if(glcd_GlyphCache[i].age < glcd_GlyphCache[e].age)
+			glcd_GlyphCache[i].age++;
+	}
+	glcd_GlyphCache[e].age = 0;
+}
+#endif
 
+	
 // This constructor creates a text area using the entire display
-// The device pointer is initialized using the global GLCD instance
-// New constuctors can be added to take an exlicit glcd instance pointer
-// if multiple glcd instances need to be supported
+// The text area is on the default display, the one GLCD uses.
+// The constructors below that take a device put the text area
+// on the display of that device (a glcd instance) instead.
 gText::gText()
 {
-   // device = (glcd_Device*)&GLCD; 
+    this->DefineArea(0,0,DISPLAY_WIDTH -1,DISPLAY_HEIGHT -1, DEFAULT_SCROLLDIR); // this should never fail
+}
+
+gText::gText(const glcd_Device &device) : glcd_Device(device)
+{
     this->DefineArea(0,0,DISPLAY_WIDTH -1,DISPLAY_HEIGHT -1, DEFAULT_SCROLLDIR); // this should never fail
 }
 
@@ -55,22 +106,40 @@ gText::gText()
 // full display area is used if any coordinate is invalid
 gText::gText(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, textMode mode) 
 {
-   //device = (glcd_Device*)&GLCD; 
+   if( ! this->DefineArea(x1,y1,x2,y2,mode))
+       this->DefineArea(0,0,DISPLAY_WIDTH -1,DISPLAY_HEIGHT -1,mode); // this should never fail
+}
+
+gText::gText(const glcd_Device &device, uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, textMode mode) : glcd_Device(device)
+{
    if( ! this->DefineArea(x1,y1,x2,y2,mode))
        this->DefineArea(0,0,DISPLAY_WIDTH -1,DISPLAY_HEIGHT -1,mode); // this should never fail
 }
 
 gText::gText(predefinedArea selection, textMode mode)
 {
-   //device = (glcd_Device*)&GLCD; 
    if( ! this->DefineArea(selection,mode))
        this->DefineArea(0,0,DISPLAY_WIDTH -1,DISPLAY_HEIGHT -1,mode); // this should never fail
 
 }
 
+gText::gText(const glcd_Device &device, predefinedArea selection, textMode mode) : glcd_Device(device)
+{
+   if( ! this->DefineArea(selection,mode))
+       this->DefineArea(0,0,DISPLAY_WIDTH -1,DISPLAY_HEIGHT -1,mode); // this should never fail
+}
+
 gText::gText(uint8_t x1, uint8_t y1, uint8_t columns, uint8_t rows, Font_t font, textMode mode)
 {
-   //device = (glcd_Device*)&GLCD; 
+   if( ! this->DefineArea(x1,y1,columns,rows,font, mode))
+   {
+       this->DefineArea(0,0,DISPLAY_WIDTH -1,DISPLAY_HEIGHT -1,mode); // this should never fail
+	  this->SelectFont(font);
+   }
+}
+
+gText::gText(const glcd_Device &device, uint8_t x1, uint8_t y1, uint8_t columns, uint8_t rows, Font_t font, textMode mode) : glcd_Device(device)
+{
    if( ! this->DefineArea(x1,y1,columns,rows,font, mode))
    {
        this->DefineArea(0,0,DISPLAY_WIDTH -1,DISPLAY_HEIGHT -1,mode); // this should never fail
@@ -275,10 +344,12 @@ void gText::ScrollUp(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2,
 	uint8_t pixels, uint8_t color)
 {
 uint8_t dy;
-uint8_t dbyte;
+uint8_t dbyte[GLCD_BLOCKBUF_SIZE];
 uint8_t sy;
-uint8_t sbyte;
+uint8_t sbyte[GLCD_BLOCKBUF_SIZE];
 uint8_t col;
+uint8_t cols;
+uint8_t i;
 
 	/*
 	 * Scrolling up more than area height?
@@ -293,28 +364,41 @@ uint8_t col;
 		return;
 	}
 
-	for(col = x1; col <= x2; col++)
+	/*
+	 * The region is scrolled a group of columns at a time
+	 * so that each LCD page of the group can be read and written
+	 * with a single block read or write.
+	 */
+	for(col = x1; col <= x2; col += cols)
 	{
+		cols = x2 - col + 1;
+		if(cols > sizeof(dbyte))
+			cols = sizeof(dbyte);
+
 		dy = y1;
 		glcd_Device::GotoXY(col, dy & ~7);
-		dbyte = glcd_Device::ReadData();
+		glcd_Device::ReadDataBlock(dbyte, cols);
 
 
 		/*
 		 * preserve bits outside/above scroll region
 		 */
 
-		dbyte &= (_BV((dy & 7)) - 1);
+		for(i = 0; i < cols; i++)
+			dbyte[i] &= (_BV((dy & 7)) - 1);
 
 		sy = dy + pixels;
 		glcd_Device::GotoXY(col, sy & ~7);
-		sbyte = glcd_Device::ReadData();
+		glcd_Device::ReadDataBlock(sbyte, cols);
 
 		while(sy <= y2)
 		{
-			if(sbyte & _BV(sy & 7))
+			for(i = 0; i < cols; i++)
 			{
-				dbyte |= _BV(dy & 7);
+				if(sbyte[i] & _BV(sy & 7))
+				{
+					dbyte[i] |= _BV(dy & 7);
+				}
 			}
 
 			sy++;
@@ -326,15 +410,15 @@ uint8_t col;
 				if(sy < DISPLAY_HEIGHT)
 				{
 					glcd_Device::GotoXY(col, sy & ~7);
-					sbyte = glcd_Device::ReadData();
+					glcd_Device::ReadDataBlock(sbyte, cols);
 				}
 			}
 
 			if((dy & 7) == 7)
 			{
-				glcd_Device::GotoXY(col, dy & ~7);	// Should be able to remove this
-				glcd_Device::WriteData(dbyte);
-				dbyte = 0;
+				glcd_Device::GotoXY(col, dy & ~7);
+				glcd_Device::WriteDataBlock(dbyte, cols);
+				memset(dbyte, 0, cols);
 			}
 			dy++;
 		}
@@ -345,26 +429,29 @@ uint8_t col;
 
 		for(uint8_t p = pixels; p; p--)
 		{
-			if(color == BLACK)
-			{
-				dbyte |= _BV(dy & 7);
-			}
-			else
+			for(i = 0; i < cols; i++)
 			{
-				dbyte &= ~_BV(dy & 7);
+				if(color == BLACK)
+				{
+					dbyte[i] |= _BV(dy & 7);
+				}
+				else
+				{
+					dbyte[i] &= ~_BV(dy & 7);
+				}
 			}
 
 			if((dy & 7) == 7)
 			{
-				glcd_Device::GotoXY(col, dy & ~7); // should be able to remove this.
-				glcd_Device::WriteData(dbyte);
-				dbyte = 0;
+				glcd_Device::GotoXY(col, dy & ~7);
+				glcd_Device::WriteDataBlock(dbyte, cols);
+				memset(dbyte, 0, cols);
 			}
 			dy++;
 		}
 
 		/*
-		 * Flush out the final destination byte
+		 * Flush out the final destination bytes
 		 */
 
 
@@ -373,16 +460,19 @@ uint8_t col;
 			dy--;
 
 			glcd_Device::GotoXY(col, dy & ~7);
-			sbyte = glcd_Device::ReadData();
+			glcd_Device::ReadDataBlock(sbyte, cols);
 			/*
 			 * Preserver bits outside/below region
 			 */
 
 			dy++;
-			sbyte &= ~(_BV((dy & 7)) - 1);
-			dbyte |= sbyte;
+			for(i = 0; i < cols; i++)
+			{
+				sbyte[i] &= ~(_BV((dy & 7)) - 1);
+				dbyte[i] |= sbyte[i];
+			}
 
-			glcd_Device::WriteData(dbyte);
+			glcd_Device::WriteDataBlock(dbyte, cols);
 		}
 	}
 
@@ -691,62 +781,28 @@ int gText::PutChar(uint8_t c)
 
 	if(c < 0x20)
 	{
+		this->BeginUpdate();
 		SpecialChar(c);
+		this->EndUpdate();
 		return 1;
 	}
 	   
-	uint8_t width = 0;
+	glcd_Glyph g;
 	uint8_t height = FontRead(this->Font+FONT_HEIGHT);
-	uint8_t bytes = (height+7)/8; /* calculates height in rounded up bytes */
-	
-	uint8_t firstChar = FontRead(this->Font+FONT_FIRST_CHAR);
-	uint8_t charCount = FontRead(this->Font+FONT_CHAR_COUNT);
-	
-	uint16_t index = 0;
-	uint8_t thielefont;
+	uint8_t thielefont = this->FindGlyph(c, height, &g);
 
-	if(c < firstChar || c >= (firstChar+charCount)) {
+	if(!thielefont) {
 		return 0; // invalid char
 	}
-	c-= firstChar;
+	thielefont--;
 
-	if( isFixedWidthFont(this->Font) {
-		thielefont = 0;
-		width = FontRead(this->Font+FONT_FIXED_WIDTH); 
-		index = c*bytes*width+FONT_WIDTH_TABLE;
-	}
-	else{
-	// variable width font, read width data, to get the index
-		thielefont = 1;
-		/*
-		 * Because there is no table for the offset of where the data
-		 * for each character glyph starts, run the table and add up all the
-		 * widths of all the characters prior to the character we
-		 * need to locate.
-		 */
-	   for(uint8_t i=0; i<c; i++) {  
-		 index += FontRead(this->Font+FONT_WIDTH_TABLE+i);
-	   }
-		/*
-		 * Calculate the offset of where the font data
-		 * for our character starts.
-		 * The index value from above has to be adjusted because
-		 * there is potentialy more than 1 byte per column in the glyph,
-		 * when the characgter is taller than 8 bits.
-		 * To account for this, index has to be multiplied
-		 * by the height in bytes because there is one byte of font
-		 * data for each vertical 8 pixels.
-		 * The index is then adjusted to skip over the font width data
-		 * and the font header information.
-		 */
+	uint8_t width = g.width;
+#ifdef GLCD_OLD_FONTDRAW
+	uint8_t bytes = (height+7)/8; /* calculates height in rounded up bytes */
+	uint16_t index = g.index;
+#endif
 
-	   index = index*bytes+charCount+FONT_WIDTH_TABLE;
-
-		/*
-		 * Finally, fetch the width of our character
-		 */
-	   width = FontRead(this->Font+FONT_WIDTH_TABLE+c);
-    }
+	this->BeginUpdate();
 
 #ifndef GLCD_NODEFER_SCROLL
 	/*
@@ -787,6 +843,26 @@ int gText::PutChar(uint8_t c)
 
 	// last but not least, draw the character
 
+	/*
+	 * A character entirely outside the clip area is skipped.
+	 * (The old font drawing code only does this, it draws partly clipped characters whole)
+	 */
+	lcdClip *clip = &this->Dev->Clip;
+
+	/*
+	 * The columns of the glyph inside the clip area, column width is the gap.
+	 */
+	uint8_t jfirst = this->x < clip->x1 ? clip->x1 - this->x : 0;
+	uint8_t jlast = this->x + width > clip->x2 ? clip->x2 - this->x : width;
+
+	if(this->x > clip->x2 || this->x + width < clip->x1 || jfirst > jlast ||
+		this->y > clip->y2 || this->y + height < clip->y1)
+	{
+		this->x = this->x+width+1;
+		this->EndUpdate();
+		return 1;
+	}
+
 #ifdef GLCD_OLD_FONTDRAW
 /*================== OLD FONT DRAWING ============================*/
 	glcd_Device::GotoXY(this->x, this->y);
@@ -836,7 +912,7 @@ int gText::PutChar(uint8_t c)
 		} else {
 			glcd_Device::WriteData(0xFF);
 		}
-		glcd_Device::GotoXY(this->x, glcd_Device::Coord.y+8);
+		glcd_Device::GotoXY(this->x, this->Dev->Coord.y+8);
 	}
 	this->x = this->x+width+1;
 
@@ -853,241 +929,366 @@ int gText::PutChar(uint8_t c)
 	 * That method (really doesn't work) and reads and writes the same LCD page 
 	 * more than once as well as not do sequential writes to memory.
 	 *
-	 * This method of rendering while much more complicated, somewhat scrambles the font 
-	 * data reads to ensure that all writes to LCD pages are always sequential and a given LCD
-	 * memory page is never read or written more than once.
-	 * And reads of LCD pages are only done at the top or bottom of the font data rendering
-	 * when necessary. 
-	 * i.e it ensures the absolute minimum number of LCD page accesses
-	 * as well as does the sequential writes as much as possible.
-	 *
+	 * PageGlyphs() makes each LCD page of the glyph from the font data bytes
+	 * that overlap it and writes it in sequential blocks, so a given LCD memory
+	 * page is never read or written more than once, and is only read when
+	 * some of its rows must be kept.
 	 */
+	this->PageGlyphs(&g, height, thielefont, jfirst, jlast);
+	this->x = this->x+width+1;
 
-	uint8_t pixels = height +1; /* 1 for gap below character*/
-	uint8_t p;
-	uint8_t dy;
-	uint8_t tfp;
-	uint8_t dp;
-	uint8_t dbyte;
-	uint8_t fdata;
-
-	for(p = 0; p < pixels;)
-	{
-		dy = this->y + p;
+/*================== END of NEW FONT DRAWING ============================*/
 
-		/*
-		 * Align to proper Column and page in LCD memory
-		 */
+#endif // NEW_FONTDRAW
 
-		glcd_Device::GotoXY(this->x, (dy & ~7));
+	this->EndUpdate();
+	return 1; // valid char
+}
 
-		uint16_t page = p/8 * width; // page must be 16 bit to prevent overflow
+/*
+ * Look up character c in the current font, height is the font height.
+ * Fills in the offset of its glyph data and its width.
+ * Returns 0 if the font has no glyph for c, 1 for a fixed width font
+ * and 2 for a variable width (Thiele) font.
+ *
+ * With GLCD_GLYPH_CACHE the glyph cache is looked in first, and a glyph
+ * that is not in it yet replaces the least recently used one if it fits.
+ */
+uint8_t gText::FindGlyph(uint8_t c, uint8_t height, glcd_Glyph *g)
+{
+	uint8_t bytes = (height+7)/8; /* calculates height in rounded up bytes */
+	uint8_t kind;
+
+#ifdef GLCD_GLYPH_CACHE
+	uint8_t e, lru = 0;
 
-		for(uint8_t j=0; j<width; j++) /* each column of font data */
+	for(e = 0; e < GLCD_GLYPH_CACHE; e++)
+	{
+		if(glcd_GlyphCache[e].font == this->Font && glcd_GlyphCache[e].c == c)
 		{
-			
-			/*
-			 * Fetch proper byte of font data.
-			 * Note:
-			 * This code "cheats" to add the horizontal space/pixel row
-			 * below the font.
-			 * It essentially creates a font pixel of 0 when the pixels are
-			 * out of the defined pixel map.
-			 *
-			 * fake a fondata read read when we are on the very last
-			 * bottom "pixel". This lets the loop logic continue to run
-			 * with the extra fake pixel. If the loop is not the
-			 * the last pixel the pixel will come from the actual
-			 * font data, but that is ok as it is 0 padded.
-			 *
-			 */
+			g->index = glcd_GlyphCache[e].index;
+			g->width = glcd_GlyphCache[e].width;
+			g->cached = glcd_GlyphCache[e].data;
+			GlyphCacheUse(e);
+			return(glcd_GlyphCache[e].kind);
+		}
+		if(glcd_GlyphCache[e].age > glcd_GlyphCache[lru].age)
+			lru = e;
+	}
+	g->cached = 0;
+#endif
+	
+	uint8_t firstChar = FontRead(this->Font+FONT_FIRST_CHAR);
+	uint8_t charCount = FontRead(this->Font+FONT_CHAR_COUNT);
+	
+	uint16_t index = 0;
+
+	if(c < firstChar || c >= (firstChar+charCount)) {
+		return 0; // invalid char
+	}
+	c-= firstChar;
+
+	if( isFixedWidthFont(this->Font) {
+		g->width = FontRead(this->Font+FONT_FIXED_WIDTH); 
+		g->index = c*bytes*g->width+FONT_WIDTH_TABLE;
+		kind = 1;
+	}
+	else
+	{
+		kind = 2;
 
-			if(p >= height)
+		// variable width font, read width data, to get the index
+#ifdef GLCD_FONT_INDEX
+		/*
+		 * Look up the sum of the widths of the characters before this one,
+		 * adding up any characters past the end of the index.
+		 */
+		uint8_t i;
+
+		if(glcd_IndexedFont != this->Font)
+		{
+			for(i = 0; i < GLCD_FONT_INDEX && i < charCount; i++)
 			{
-				/*
-				 * fake a font data read for padding below character.
-				 */
-				fdata = 0;
+				glcd_FontIndex[i] = index;
+				index += FontRead(this->Font+FONT_WIDTH_TABLE+i);
 			}
-			else
-			{
-				fdata = FontRead(this->Font+index+page+j);
+			glcd_IndexedFont = this->Font;
+		}
+		i = c < GLCD_FONT_INDEX ? c : GLCD_FONT_INDEX-1;
+		index = glcd_FontIndex[i];
+		for(; i<c; i++) {
+			index += FontRead(this->Font+FONT_WIDTH_TABLE+i);
+		}
+#else
+		/*
+		 * Because there is no table for the offset of where the data
+		 * for each character glyph starts, run the table and add up all the
+		 * widths of all the characters prior to the character we
+		 * need to locate.
+		 */
+		for(uint8_t i=0; i<c; i++) {  
+			index += FontRead(this->Font+FONT_WIDTH_TABLE+i);
+		}
+#endif
+		/*
+		 * Calculate the offset of where the font data
+		 * for our character starts.
+		 * The index value from above has to be adjusted because
+		 * there is potentialy more than 1 byte per column in the glyph,
+		 * when the characgter is taller than 8 bits.
+		 * To account for this, index has to be multiplied
+		 * by the height in bytes because there is one byte of font
+		 * data for each vertical 8 pixels.
+		 * The index is then adjusted to skip over the font width data
+		 * and the font header information.
+		 */
 
-				/*
-				 * Have to shift font data because Thiele shifted residual
-				 * font bits the wrong direction for LCD memory.
-				 *
-				 * The real solution to this is to fix the variable width font format to
-				 * not shift the residual bits the wrong direction!!!!
-				 */
-				if(thielefont && (height - (p&~7)) < 8)
-				{
-					fdata >>= 8 - (height & 7);
-				}
-			}
+		g->index = index*bytes+charCount+FONT_WIDTH_TABLE;
 
-			if(this->FontColor == WHITE)
-				fdata ^= 0xff;	/* inverted data for "white" font color	*/
+		/*
+		 * Finally, fetch the width of our character
+		 */
+		g->width = FontRead(this->Font+FONT_WIDTH_TABLE+c);
+	}
 
+#ifdef GLCD_GLYPH_CACHE
+	uint16_t size = g->width * bytes;
+
+	if(size <= GLCD_GLYPH_CACHE_SIZE)
+	{
+		for(uint16_t i = 0; i < size; i++)
+		{
+			uint8_t fdata = FontRead(this->Font+g->index+i);
 
 			/*
-			 * Check to see if a quick full byte write of font
-			 * data can be done.
+			 * Have to shift the last font page because Thiele shifted residual
+			 * font bits the wrong direction for LCD memory.
 			 */
+			if(kind == 2 && (height & 7) && i >= (bytes-1) * g->width)
+				fdata >>= 8 - (height & 7);
+			glcd_GlyphCache[lru].data[i] = fdata;
+		}
+		glcd_GlyphCache[lru].font = this->Font;
+		glcd_GlyphCache[lru].index = g->index;
+		glcd_GlyphCache[lru].c = c + firstChar;
+		glcd_GlyphCache[lru].width = g->width;
+		glcd_GlyphCache[lru].kind = kind;
+		glcd_GlyphCache[lru].age = 0xff;	// older than all the others
+		GlyphCacheUse(lru);
+		g->cached = glcd_GlyphCache[lru].data;
+	}
+#endif
+	return(kind);
+}
 
-			if(!(dy & 7) && !(p & 7) && ((pixels -p) >= 8))
-			{
-				/*
-				 * destination pixel is on a page boundary
-				 * Font data is on byte boundary
-				 * And there are 8 or more pixels left
-				 * to paint so a full byte write can be done.
-				 */
-					
-					glcd_Device::WriteData(fdata);
-					continue;
-			}
-			else
-			{
-					/*
-					 * No, so must fetch byte from LCD memory.
-					 */
-					dbyte = glcd_Device::ReadData();
-			}
+/*
+ * Where font page p of the data of glyph g starts,
+ * in the glyph cache if it is in it (already shifted) or else in the font.
+ */
+static inline const uint8_t *GlyphPage(Font_t font, const glcd_Glyph *g, uint8_t p)
+{
+#ifdef GLCD_GLYPH_CACHE
+	if(g->cached)
+		return(g->cached + p * (uint16_t)g->width);
+#endif
+	return(font + g->index + p * (uint16_t)g->width); // 16 bit to prevent overflow
+}
 
-			/*
-			 * At this point there is either not a full page of data
-			 * left to be painted  or the font data spans multiple font
-			 * data bytes. (or both) So, the font data bits will be painted
-			 * into a byte and then written to the LCD memory.page.
-			 */
+/*
+ * Draw a run of glyphs, each followed by its gap column, a whole LCD page at a time,
+ * see PutChar() and PutRun().
+ * The glyphs start at the text position and jfirst and jlast are the columns of the
+ * run to draw, relative to it. Each LCD page is made across all the glyphs in a buffer
+ * and written in blocks, so a page is only addressed once per run rather than once
+ * per glyph.
+ * When the glyphs are not page aligned an LCD page holds the bottom rows of one page
+ * of font data and the top rows of the next, so for each column the two font bytes
+ * are put together in a 16 bit word and shifted into place with a single shift
+ * and merged under a mask of the rows to paint.
+ * The LCD page is only read first when some of its rows are above or below the glyphs
+ * and their gap row or outside the clip area.
+ */
+void gText::PageGlyphs(const glcd_Glyph *g, uint8_t height, uint8_t thielefont, uint8_t jfirst, uint8_t jlast)
+{
+	uint8_t buf[GLCD_BLOCKBUF_SIZE];
+	uint8_t orig[GLCD_BLOCKBUF_SIZE];
+	lcdClip *clip = &this->Dev->Clip;
+	uint8_t pixels = height +1; /* 1 for gap below character*/
+	uint8_t xorval = this->FontColor == WHITE ? 0xff : 0;
+	uint8_t shift = 8 - (this->y & 7);	/* font word to LCD page shift */
+	uint8_t top = this->y & ~7;
+	uint8_t dy, p, mask, j, n, i;
+	uint8_t hi, lo;		/* font data bytes for the bottom and top of this LCD page are used */
+	uint8_t hishift, loshift;
+	uint8_t col;		/* column in the current glyph */
+	const glcd_Glyph *gp;
+	uint16_t fdata;
+	const uint8_t *fp;
+
+	for(dy = top; dy - this->y < pixels && dy <= clip->y2; dy += 8)
+	{
+		/*
+		 * mask has the rows of this page to paint,
+		 * the glyph rows that are inside the clip area
+		 */
+		mask = dy < this->y ? 0xff << (this->y & 7) : 0xff;
+		if(this->y + pixels - dy < 8)
+			mask &= _BV(this->y + pixels - dy) - 1;
+		if(dy < clip->y1)
+			mask &= clip->y1 - dy >= 8 ? 0 : 0xff << (clip->y1 - dy);
+		if(dy + 7 > clip->y2)
+			mask &= 0xff >> (dy + 7 - clip->y2);
+		if(!mask)
+			continue;
+
+		/*
+		 * Font page p lands in the bottom of this LCD page and font page p-1 in the top.
+		 * Past the last font page is the gap row below the character.
+		 *
+		 * Have to shift the last font page because Thiele shifted residual
+		 * font bits the wrong direction for LCD memory.
+		 */
+		p = (dy - top) / 8;
+		hi = p * 8 < height;
+		lo = p && shift != 8;
+		hishift = thielefont && (height - p*8) < 8 ? 8 - (height & 7) : 0;
+		loshift = thielefont && (height - (p-1)*8) < 8 ? 8 - (height & 7) : 0;
 
+		/*
+		 * find the glyph and column of the first column to draw
+		 */
+		gp = g;
+		col = jfirst;
+		while(col > gp->width)
+		{
+			col -= gp->width + 1;
+			gp++;
+		}
+		fp = GlyphPage(this->Font, gp, p);
 
-			tfp = p;		/* font pixel bit position 		*/
-			dp = dy & 7;	/* data byte pixel bit position */
+		for(j = jfirst; j <= jlast; j += n)
+		{
+			n = jlast - j + 1 < (int)sizeof(buf) ? jlast - j + 1 : sizeof(buf);
+			glcd_Device::GotoXY(this->x + j, dy);
+			if(mask != 0xff)
+				glcd_Device::ReadDataBlock(orig, n);
 
-			/*
-			 * paint bits until we hit bottom of page/byte
-			 * or run out of pixels to paint.
-			 */
-			while((dp <= 7) && (tfp) < pixels)
+			for(i = 0; i < n; i++)
 			{
-				if(fdata & _BV(tfp & 7))
-				{
-					dbyte |= _BV(dp);
-				}
-				else
+				fdata = 0;	/* the gap column */
+				if(col < gp->width)
 				{
-					dbyte &= ~_BV(dp);
+#ifdef GLCD_GLYPH_CACHE
+					if(gp->cached)
+					{
+						if(hi)
+							fdata = fp[col] << 8;
+						if(lo)
+							fdata |= fp[col-gp->width];
+					}
+					else
+#endif
+					{
+						if(hi)
+							fdata = (uint16_t)(FontRead(fp+col) >> hishift) << 8;
+						if(lo)
+							fdata |= FontRead(fp+col-gp->width) >> loshift;
+					}
+					col++;
 				}
-
-				/*
-				 * Check for crossing font data bytes
-				 */
-				if((tfp & 7)== 7)
+				else if(j + i < jlast)
 				{
-					fdata = FontRead(this->Font+index+page+j+width);
-
 					/*
-					 * Have to shift font data because Thiele shifted residual
-					 * font bits the wrong direction for LCD memory.
-					 *
+					 * on to the next glyph after the gap column
 					 */
-
-					if((thielefont) && ((height - tfp) < 8))
-					{
-						fdata >>= (8 - (height & 7));
-					}
-
-					if(this->FontColor == WHITE)
-						fdata ^= 0xff;	/* inverted data for "white" color	*/
+					col = 0;
+					gp++;
+					fp = GlyphPage(this->Font, gp, p);
 				}
-				tfp++;
-				dp++;
+				fdata = (uint8_t)(fdata >> shift) ^ xorval;
+				buf[i] = mask == 0xff ? fdata : (orig[i] & ~mask) | (fdata & mask);
 			}
-
-			/*
-			 * Now flush out the painted byte.
-			 */
-			glcd_Device::WriteData(dbyte);
+			glcd_Device::WriteDataBlock(buf, n);
 		}
+	}
+}
 
-		/*
-		 * now create a horizontal gap (vertical line of pixels) between characters.
-		 * Since this gap is "white space", the pixels painted are oposite of the
-		 * font color.
-		 *
-		 * Since full LCD pages are being written, there are 4 combinations of filling
-		 * in the this gap page.
-		 *	- pixels start at bit 0 and go down less than 8 bits
-		 *	- pixels don't start at 0 but go down through bit 7
-		 *	- pixels don't start at 0 and don't go down through bit 7 (fonts shorter than 6 hi)
-		 *	- pixels start at bit 0 and go down through bit 7 (full byte)
-		 *
-		 * The code below creates a mask of the bits that should not be painted.
-		 *
-		 * Then it is easy to paint the desired bits since if the color is WHITE,
-		 * the paint bits are set, and if the coloer is not WHITE the paint bits are stripped.
-		 * and the paint bits are the inverse of the desired bits mask.
-		 */
-
-
-		
-		if((dy & 7) || (pixels - p < 8))
-		{
-		uint8_t mask = 0;
-
-			dbyte = glcd_Device::ReadData();
-
-			if(dy & 7)
-				mask |= _BV(dy & 7) -1;
-
-			if((pixels-p) < 8)
-				mask |= ~(_BV(pixels - p) -1);
-
-
-			if(this->FontColor == WHITE)
-				dbyte |= ~mask;	
-			else
-				dbyte &= mask;
-
-		}
-		else
-		{
-			if(this->FontColor == WHITE)
-				dbyte = 0xff;
-			else
-				dbyte = 0;
-		}
+/*
+ * Output the characters of str, up to len of them or the first NUL,
+ * str is in program memory when progmem is set.
+ *
+ * The characters that fit on the current text line are laid out first
+ * (up to GLCD_TEXTRUN_SIZE of them) and then drawn together by PageGlyphs().
+ * Anything else, special characters, characters that are not in the font,
+ * a character that wraps the line or a deferred scroll, goes through PutChar().
+ *
+ * Returns the number of characters used, 0 at the end of the string.
+ */
+size_t gText::PutRun(const char *str, size_t len, uint8_t progmem)
+{
+	glcd_Glyph g[GLCD_TEXTRUN_SIZE];
+	lcdClip *clip = &this->Dev->Clip;
+	uint8_t c = 0;
+	uint8_t n;
+	uint8_t x = this->x;
+	uint8_t height = 0;
+	uint8_t thielefont = 0;
 
-		glcd_Device::WriteData(dbyte);
+	if(this->Font)
+		height = FontRead(this->Font+FONT_HEIGHT);
 
+	for(n = 0; n < len && n < GLCD_TEXTRUN_SIZE; n++)
+	{
+		c = progmem ? pgm_read_byte(str+n) : str[n];
+#ifdef GLCD_OLD_FONTDRAW
+		break;		// the old font drawing code draws a character at a time
+#endif
+		if(c < 0x20 || this->Font == 0)
+			break;
+#ifndef GLCD_NODEFER_SCROLL
+		if(this->need_scroll)
+			break;
+#endif
+#ifdef GLCD_GLYPH_CACHE
 		/*
-		 * advance the font pixel for the pixels
-		 * just painted.
+		 * The glyphs of a run are the most recently used ones, so they stay
+		 * in the glyph cache while the run is laid out as long as it has
+		 * no more glyphs than the cache.
 		 */
-
-		p += 8 - (dy & 7);
+		if(n >= GLCD_GLYPH_CACHE)
+			break;
+#endif
+		uint8_t kind = this->FindGlyph(c, height, &g[n]);
+		if(!kind || x + g[n].width > this->tarea.x2)
+			break;
+		thielefont = kind - 1;
+		x += g[n].width + 1;
 	}
 
+	if(n == 0)
+	{
+		if(len == 0 || c == 0)
+			return 0;
+		this->PutChar(c);
+		return 1;
+	}
 
 	/*
-	 * Since this rendering code always starts off with a GotoXY() it really isn't necessary
-	 * to do a real GotoXY() to set the h/w location after rendering a character.
-	 * We can get away with only setting the s/w version of X & Y.
-	 *
-	 * Since y didn't change while rendering, it is still correct.
-	 * But update x for the pixels rendered.
-	 *
+	 * Draw the columns of the run inside the clip area, x is the column past the
+	 * last gap column.
 	 */
+	uint8_t jfirst = this->x < clip->x1 ? clip->x1 - this->x : 0;
+	uint8_t jlast = x - 1 > clip->x2 ? clip->x2 - this->x : x - 1 - this->x;
 
-	this->x = this->x+width+1;
-
-/*================== END of NEW FONT DRAWING ============================*/
-
-#endif // NEW_FONTDRAW
-
-	return 1; // valid char
+	if(!(this->x > clip->x2 || x - 1 < clip->x1 || jfirst > jlast ||
+		this->y > clip->y2 || this->y + height < clip->y1))
+	{
+		this->BeginUpdate();
+		this->PageGlyphs(g, height, thielefont, jfirst, jlast);
+		this->EndUpdate();
+	}
+	this->x = x;
+	return n;
 }
 
 
@@ -1108,13 +1309,14 @@ int gText::PutChar(uint8_t c)
  */
 
 
-void gText::Puts(char *str)
+void gText::Puts(const char *str)
 {
-    while(*str)
-	{
-        this->PutChar((uint8_t)*str);
-        str++;
-    }
+size_t n;
+
+	this->BeginUpdate();
+	while((n = this->PutRun(str, (size_t)-1, 0)) != 0)
+		str += n;
+	this->EndUpdate();
 }
 
 /**
@@ -1134,10 +1336,26 @@ void gText::Puts(char *str)
  */
 void gText::Puts(const String &str)
 {
-	for (int i = 0; i < str.length(); i++)
+char buf[GLCD_TEXTRUN_SIZE];
+unsigned int i = 0;
+size_t n;
+
+	this->BeginUpdate();
+	while(i < str.length())
 	{
-		write(str[i]);
+		/*
+		 * copy the next run worth of characters out of the string
+		 */
+		for(n = 0; n < sizeof(buf) && i + n < str.length(); n++)
+			buf[n] = str[i + n];
+		if((n = this->PutRun(buf, n, 0)) == 0)
+		{
+			this->PutChar(0);	// a NUL inside the string
+			n = 1;
+		}
+		i += n;
 	}
+	this->EndUpdate();
 }
 
 /**
@@ -1158,13 +1376,12 @@ void gText::Puts(const String &str)
 
 void gText::Puts_P(PGM_P str)
 {
-uint8_t c;
+size_t n;
 
-    while((c = pgm_read_byte(str)) != 0)
-	{
-        this->PutChar(c);
-        str++;
-    }
+	this->BeginUpdate();
+	while((n = this->PutRun(str, (size_t)-1, 1)) != 0)
+		str += n;
+	this->EndUpdate();
 }
 
 /**
@@ -1470,6 +1687,17 @@ void gText::SelectFont(Font_t font,uint8_t color, FontCallback callback)
 	this->Font = font;
 	FontRead = callback;  // this sets the callback that will be used by all instances of gText
 	this->FontColor = color;
+#ifdef GLCD_FONT_INDEX
+	glcd_IndexedFont = 0;	// the font data or callback may have changed, index it again
+#endif
+#ifdef GLCD_GLYPH_CACHE
+	if(callback != glcd_GlyphCacheRead)
+	{
+		for(uint8_t e = 0; e < GLCD_GLYPH_CACHE; e++)
+			glcd_GlyphCache[e].font = 0;	// the glyphs were read from other font data
+		glcd_GlyphCacheRead = callback;
+	}
+#endif
 }
 
 /**
@@ -1609,7 +1837,7 @@ uint16_t gText::StringWidth_P(String &str)
 {
 	uint16_t width = 0;
 
-	for (int i = 0; i < str.length(); i++)
+	for (unsigned int i = 0; i < str.length(); i++)
 	{
 		width += this->CharWidth(str[i]);
 	}
@@ -1664,6 +1892,37 @@ size_t gText::write(uint8_t c)
 {
 	return(this->PutChar(c));
 } 
+
+/**
+ * output characters to the text area
+ * @param buffer the characters to output
+ * @param size the number of characters
+ *
+ * This method is used by the Print base class to output strings,
+ * the characters are drawn a run at a time like Puts().
+ * @see Puts()
+ */
+size_t gText::write(const uint8_t *buffer, size_t size)
+{
+size_t n, count = size;
+
+	if(this->Font == 0)
+		return 0; // no font selected
+
+	this->BeginUpdate();
+	while(size)
+	{
+		if((n = this->PutRun((const char *)buffer, size, 0)) == 0)
+		{
+			this->PutChar(0);	// a NUL inside the buffer
+			n = 1;
+		}
+		buffer += n;
+		size -= n;
+	}
+	this->EndUpdate();
+	return(count);
+}
 #endif
 
 #ifndef USE_ARDUINO_FLASHSTR
@@ -1747,9 +2006,11 @@ static FILE stdiostr;
 	fdev_setup_stream(&stdiostr, glcdputc, NULL, _FDEV_SETUP_WRITE);
 	fdev_set_udata(&stdiostr, this);
 
+	this->BeginUpdate();
 	va_start(ap, format);
 	vfprintf(&stdiostr, format, ap);
 	va_end(ap);
+	this->EndUpdate();
 }
 
 /**
@@ -1772,9 +2033,11 @@ static FILE stdiostr;
 	fdev_setup_stream(&stdiostr, glcdputc, NULL, _FDEV_SETUP_WRITE);
 	fdev_set_udata(&stdiostr, this);
 
+	this->BeginUpdate();
 	va_start(ap, format);
 	vfprintf_P(&stdiostr, format, ap);
 	va_end(ap);
+	this->EndUpdate();
 }
 
 #endif
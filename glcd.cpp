@@ -38,7 +38,19 @@
 
 
 glcd::glcd(){
-   glcd_Device::Inverted = NON_INVERTED; 
+   this->Dev->Inverted = NON_INVERTED; 
+}
+
+/**
+ * Create a glcd object for another display
+ *
+ * @param state the state of the display, see glcd_DeviceState
+ *
+ * The global GLCD object uses the default display,
+ * this is only needed when driving more than one display.
+ */
+glcd::glcd(glcd_DeviceState &state) : gText(glcd_Device(state)){
+   this->Dev->Inverted = NON_INVERTED; 
 }
 
 /**
@@ -103,26 +115,38 @@ void glcd::ClearScreen(uint8_t color){
  * the wikipedia example code.
  */
 
-#define _GLCD_absDiff(x,y) ((x>y) ?  (x-y) : (y-x))
+#define _GLCD_absDiff(x,y) ((x>y) ?  (uint16_t)((uint16_t)x-(uint16_t)y) : (uint16_t)((uint16_t)y-(uint16_t)x))
 #define _GLCD_swap(a,b) \
 do\
 {\
-uint8_t t;\
+int16_t t;\
 	t=a;\
 	a=b;\
 	b=t;\
 } while(0)
 
+#define _GLCD_max(a,b) ((a) > (b) ? (a) : (b))
+
+/*
+ * Cohen-Sutherland outcode of x,y: which sides of the clip area it is off
+ */
+#define _GLCD_outcode(x,y) \
+	(((x) < this->Dev->Clip.x1 ? 1 : 0) | ((x) > this->Dev->Clip.x2 ? 2 : 0) | \
+	 ((y) < this->Dev->Clip.y1 ? 4 : 0) | ((y) > this->Dev->Clip.y2 ? 8 : 0))
+
 /**
  * Draw a line
  *
- * @param x1 a value from 0 to GLCD.Width-1  indicating start x coordinate 
- * @param y1 a value fron 0 to GLCD.Height-1 indicating start y coordinate
- * @param x2 a value from 0 to GLCD.Width-1  indicating end x coordinate 
- * @param y2 a value fron 0 to GLCD.Height-1 indicating end y coordinate
+ * @param x1 start x coordinate 
+ * @param y1 start y coordinate
+ * @param x2 end x coordinate 
+ * @param y2 end y coordinate
  * @param color BLACK or WHITE 
  *
  * Draws a line starting at x1,y2 and ending at x2,y2.
+ * Only the part of the line inside the clip area is drawn,
+ * so either end can be off the display (or negative).
+ * The pixels drawn are the same as those of the whole line.
  *
  * Color is optional and defaults to BLACK.
  *
@@ -131,10 +155,17 @@ uint8_t t;\
  *
  */
 
-void glcd::DrawLine(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t color)
+void glcd::DrawLine(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t color)
 {
-uint8_t deltax, deltay, x,y, steep;
-int8_t error, ystep;
+uint16_t deltax, deltay;
+uint8_t x, y, steep, n;
+uint16_t error;		// 0 to deltax-1, deltax can be up to 65535
+int8_t ystep;
+uint8_t px, py;
+uint8_t xlo, xhi, ylo, yhi;		// clip area along and across the line
+int32_t kfirst, klast, mmin, mmax, k;
+uint32_t prod;		// kfirst*deltay, up to 65535*65535
+DotSpan span;
 
 #ifdef XXX
 	/*
@@ -154,6 +185,13 @@ int8_t error, ystep;
 	if(y2>=DISPLAY_HEIGHT) y2=0;
 #endif
 
+	/*
+	 * A line with both ends off the same side of the clip area
+	 * is entirely outside of it.
+	 */
+	if(_GLCD_outcode(x1, y1) & _GLCD_outcode(x2, y2))
+		return;
+
 	steep = _GLCD_absDiff(y1,y2) > _GLCD_absDiff(x1,x2);  
 
 	if ( steep )
@@ -168,22 +206,153 @@ int8_t error, ystep;
 		_GLCD_swap(y1, y2);
 	}
 
-	deltax = x2 - x1;
+	deltax = (uint16_t)x2 - (uint16_t)x1;
 	deltay =_GLCD_absDiff(y2,y1);  
 	error = deltax / 2;
 	y = y1;
 	if(y1 < y2) ystep = 1;  else ystep = -1;
 
-	for(x = x1; x <= x2; x++)
+	if(steep)
+	{
+		xlo = this->Dev->Clip.y1; xhi = this->Dev->Clip.y2;
+		ylo = this->Dev->Clip.x1; yhi = this->Dev->Clip.x2;
+	}
+	else
+	{
+		xlo = this->Dev->Clip.x1; xhi = this->Dev->Clip.x2;
+		ylo = this->Dev->Clip.y1; yhi = this->Dev->Clip.y2;
+	}
+
+	/*
+	 * Find the steps k (0 to deltax) of the line that are inside the clip area.
+	 * Rather than move the end points to where the line crosses the clip edges,
+	 * which rounds them and changes the pixels drawn, this is done exactly.
+	 * After k steps y has moved m = ceil((k*deltay - deltax/2) / deltax) pixels
+	 * (0 when that is negative) so y has moved at least M pixels from
+	 * step ((M-1)*deltax + deltax/2)/deltay + 1 on
+	 * and at most M pixels up to step (M*deltax + deltax/2)/deltay.
+	 */
+	kfirst = x1 < xlo ? (int32_t)xlo - x1 : 0;
+	klast = x2 > xhi ? (int32_t)xhi - x1 : deltax;
+	if(ystep > 0)
+	{
+		mmin = (int32_t)ylo - y1;	// least pixels y has to move to be inside
+		mmax = (int32_t)yhi - y1;	// most pixels y can move and still be inside
+	}
+	else
+	{
+		mmin = (int32_t)y1 - yhi;
+		mmax = (int32_t)y1 - ylo;
+	}
+	if(mmax < 0)
+		return;
+	if(mmin > 0)
+	{
+		if(mmin > deltay)
+			return;
+		k = ((uint32_t)(mmin-1)*deltax + error)/deltay + 1;
+		if(k > kfirst)
+			kfirst = k;
+	}
+	if(deltay && mmax < deltay)
+	{
+		k = ((uint32_t)mmax*deltax + error)/deltay;
+		if(k < klast)
+			klast = k;
+	}
+	if(kfirst > klast)
+		return;
+
+	/*
+	 * y and error as they are after kfirst steps.
+	 * The products all fit in 32 bits unsigned, but not signed.
+	 */
+	prod = (uint32_t)kfirst * deltay;
+	mmin = prod > error ? (prod - error + deltax - 1) / deltax : 0;
+	y = y1 + ystep * mmin;
+	error = (uint32_t)mmin * deltax - prod + error;
+	n = klast - kfirst;		// no more than the width of the clip area
+
+	this->BeginUpdate();
+
+	/*
+	 * Rather than a SetDot() for each pixel, the pixels are collected
+	 * into a span of adjacent columns on the same page, a bit mask per column.
+	 * Each span is then written with a single read-modify-write of its columns.
+	 * Columns go left to right, except for steep lines going up to the right
+	 * where the span is collected right to left.
+	 *
+	 * error is kept from 0 to deltax-1 by checking it before subtracting deltay
+	 * rather than after, so it fits in 16 bits unsigned for any line.
+	 */
+	span.n = 0;
+	span.dir = steep ? ystep : 1;
+
+	x = x1 + kfirst;
+	do
 	{
-		if (steep) this->SetDot(y,x, color); else this->SetDot(x,y, color);
-   		error = error - deltay;
-		if (error < 0)
+		if (steep) { px = y; py = x; } else { px = x; py = y; }
+
+		this->SpanDot(span, px, py, color);
+		if (error < deltay)
 		{
 			y = y + ystep;
-			error = error + deltax;
+			error = error + (deltax - deltay);
     	}
+		else
+   			error = error - deltay;
+		x++;
+	} while(n--);
+	this->SpanFlush(span, color);
+	this->EndUpdate();
+}
+
+/*
+ * Add pixel x,y to a span.
+ * The span is written out first if x,y is not in the span's last column
+ * or the next one over on the same page.
+ */
+void glcd::SpanDot(DotSpan &span, uint8_t x, uint8_t y, uint8_t color)
+{
+	if(span.n && y/8 == span.page)
+	{
+		uint8_t next = span.x + span.n*span.dir;
+
+		if(x == (uint8_t)(next - span.dir))
+		{
+			span.masks[span.n-1] |= _BV(y%8);		// same column
+			return;
+		}
+		if(x == next && span.n < sizeof(span.masks))
+		{
+			span.masks[span.n++] = _BV(y%8);		// next column
+			return;
+		}
+	}
+	this->SpanFlush(span, color);
+	span.x = x;
+	span.page = y/8;
+	span.masks[0] = _BV(y%8);
+	span.n = 1;
+}
+
+/*
+ * Write the pixels collected in a span with a single read-modify-write of its columns.
+ * masks[i] has the pixels on page for column x + i*dir.
+ */
+void glcd::SpanFlush(DotSpan &span, uint8_t color)
+{
+	if(!span.n)
+		return;
+	if(span.dir < 0)
+	{
+		for(uint8_t i = 0; i < span.n/2; i++)
+			_GLCD_swap(span.masks[i], span.masks[span.n-1-i]);
+		span.x -= span.n-1;
 	}
+	this->GotoXY(span.x, span.page*8);
+	this->SetPixelMasks(span.masks, span.n, color);
+	span.n = 0;
 }
 
 /**
@@ -211,11 +380,13 @@ int8_t error, ystep;
  * @see DrawRoundRect()
  */
 
-void glcd::DrawRect(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t color) {
+void glcd::DrawRect(int16_t x, int16_t y, uint8_t width, uint8_t height, uint8_t color) {
+	this->BeginUpdate();
 	DrawHLine(x, y, width, color);				// top
 	DrawHLine(x, y+height, width, color);		// bottom
 	DrawVLine(x, y, height, color);			    // left
 	DrawVLine(x+width, y, height, color);		// right
+	this->EndUpdate();
 }
 
 /**
@@ -237,37 +408,133 @@ void glcd::DrawRect(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t
  * @see DrawRect()
  */
 
-void glcd::DrawRoundRect(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t radius, uint8_t color) {
-  	int16_t tSwitch; 
-	uint8_t x1 = 0, y1 = radius;
+void glcd::DrawRoundRect(int16_t x, int16_t y, uint8_t width, uint8_t height, uint8_t radius, uint8_t color) {
+/*
+ * The corners are quarter circles from Bresenham's circle algorithm.
+ * Rather than plotting the 8 symmetric points of each step with SetDot()
+ * (neighbouring steps mostly land in the same glcd byte so it gets
+ * read and written over and over), the outline is drawn a column at a time
+ * working out from the middle to each side.
+ * The pixels of each column go into a span for the top of the shape and
+ * a span for the bottom so every glcd byte on the outline
+ * gets a single read-modify-write.
+ *
+ * Walking the columns outwards goes forwards through the octant
+ * with one pixel per column, then backwards through the other octant
+ * with a vertical run of pixels per column.
+ * So the octant is stepped through once up front to record the steps
+ * where y drops, which is all that is needed to go back through it.
+ */
+int16_t tSwitch;
+int16_t x1, y1;
+uint8_t ysteps[24] = {0};	// a bit per step, enough for a radius of 255
+uint8_t xend, yend, d, k, lo, hi;
+int16_t xl = x + radius, xr = x + width - radius;	// corner centers
+int16_t yt = y + radius, yb = y + height - radius;
+int16_t c;
+int8_t side;
+DotSpan spans[2];	// top and bottom of the shape
+
+#define _GLCD_ystep(k) ((ysteps[(k)/8] >> ((k)%8)) & 1)
+
+	x1 = 0;
+	y1 = radius;
   	tSwitch = 3 - 2 * radius;
-	
 	while (x1 <= y1) {
-	    this->SetDot(x+radius - x1, y+radius - y1, color);
-	    this->SetDot(x+radius - y1, y+radius - x1, color);
-
-	    this->SetDot(x+width-radius + x1, y+radius - y1, color);
-	    this->SetDot(x+width-radius + y1, y+radius - x1, color);
-	    
-	    this->SetDot(x+width-radius + x1, y+height-radius + y1, color);
-	    this->SetDot(x+width-radius + y1, y+height-radius + x1, color);
-
-	    this->SetDot(x+radius - x1, y+height-radius + y1, color);
-	    this->SetDot(x+radius - y1, y+height-radius + x1, color);
-
 	    if (tSwitch < 0) {
 	    	tSwitch += (4 * x1 + 6);
 	    } else {
 	    	tSwitch += (4 * (x1 - y1) + 10);
 	    	y1--;
+	    	ysteps[x1/8] |= _BV(x1%8);
 	    }
 	    x1++;
 	}
-	  	
-	this->DrawHLine(x+radius, y, width-(2*radius), color);			// top
-	this->DrawHLine(x+radius, y+height, width-(2*radius), color);	// bottom
-	this->DrawVLine(x, y+radius, height-(2*radius), color);			// left
-	this->DrawVLine(x+width, y+radius, height-(2*radius), color);	// right
+	xend = x1 - 1;						// last step
+	yend = y1 + _GLCD_ystep(xend);		// y of the last step
+
+	if(_GLCD_outcode(x, y) & _GLCD_outcode(x+width, y+height))
+		return;		// entirely outside the clip area
+
+	this->BeginUpdate();
+	spans[0].n = spans[1].n = 0;
+	spans[0].dir = spans[1].dir = -1;
+
+	/*
+	 * straight top and bottom between the corners, then the left corners
+	 * working right to left, then the right corners working left to right.
+	 */
+	for(c = xr-1; c > xl; c--)
+		this->OutlineColumn(spans, c, y, y, y+height, y+height, color);
+
+	for(side = -1; side <= 1; side += 2)
+	{
+		y1 = radius;
+		k = xend;
+		for(d = 0; d <= radius; d++)
+		{
+			if(d < yend)
+			{
+				lo = hi = y1;					// forwards through the first octant
+				y1 -= _GLCD_ystep(d);
+			}
+			else
+			{
+				hi = k;							// backwards through the second one
+				while(k && !_GLCD_ystep(k-1))
+					k--;
+				lo = k--;
+			}
+
+			/*
+			 * the outermost column includes the straight side
+			 * and the middle column is shared when there is no straight top and bottom.
+			 */
+			if(d || side < 0 || xr != xl)
+				this->OutlineColumn(spans, (side < 0 ? xl : xr) + side*d,
+					yt - hi, d == radius ? yb : yt - lo, yb + lo, yb + hi, color);
+			if(d == radius)
+				break;		// d would wrap for a radius of 255
+		}
+		this->SpanFlush(spans[0], color);
+		this->SpanFlush(spans[1], color);
+		spans[0].dir = spans[1].dir = 1;
+	}
+	this->EndUpdate();
+#undef _GLCD_ystep
+}
+
+/*
+ * Add the pixels in column x from y1 to y2 (top of the shape) and y3 to y4
+ * (bottom of the shape) to the top and bottom spans.
+ * Bottom pixels on the page the top span ended on in this column
+ * go into the top span so that glcd byte is only written once.
+ */
+void glcd::OutlineColumn(DotSpan *spans, int16_t x, int16_t y1, int16_t y2, int16_t y3, int16_t y4, uint8_t color)
+{
+	int16_t y;
+
+	if(x < this->Dev->Clip.x1 || x > this->Dev->Clip.x2)
+		return;
+	if(y3 <= y2 + 1)
+	{
+		if(y4 > y2)
+			y2 = y4;				// the two meet, make them one
+		y3 = y4 + 1;
+	}
+	if(y2 > this->Dev->Clip.y2)
+		y2 = this->Dev->Clip.y2;
+	if(y4 > this->Dev->Clip.y2)
+		y4 = this->Dev->Clip.y2;
+	for(y = _GLCD_max(y1, this->Dev->Clip.y1); y <= y2; y++)
+		this->SpanDot(spans[0], x, y, color);
+	for(y = _GLCD_max(y3, this->Dev->Clip.y1); y <= y4; y++)
+	{
+		if(spans[0].n && spans[0].page == y/8 && spans[0].x + (spans[0].n-1)*spans[0].dir == x)
+			this->SpanDot(spans[0], x, y, color);
+		else
+			this->SpanDot(spans[1], x, y, color);
+	}
 }
 
 /**
@@ -304,7 +571,7 @@ void glcd::DrawRoundRect(uint8_t x, uint8_t y, uint8_t width, uint8_t height, ui
  * @see InvertRect()
  */
 
-void glcd::FillRect(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t color) {
+void glcd::FillRect(int16_t x, int16_t y, uint8_t width, uint8_t height, uint8_t color) {
     this->SetPixels(x,y,x+width,y+height,color);
 }
 
@@ -318,6 +585,7 @@ void glcd::FillRect(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t
  *
  * Inverts the pixels in the rectanglular area of the specified width and height.
  * BLACK pixels becom WHITE and WHITE pixels become BLACK.
+ * Only the part of the area inside the clip area is inverted.
  *
  * See FillRect() for full the full details of the rectangular area.
  *
@@ -331,8 +599,23 @@ void glcd::FillRect(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t
  */
 
 
-void glcd::InvertRect(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
-	uint8_t mask, pageOffset, h, i, data, tmpData;
+void glcd::InvertRect(int16_t x, int16_t y, uint8_t width, uint8_t height) {
+	uint8_t mask, pageOffset, h;
+	int16_t x2 = x + width, y2 = y + height;
+
+	/*
+	 * only invert the part inside the clip area
+	 */
+	if(x < this->Dev->Clip.x1) x = this->Dev->Clip.x1;
+	if(y < this->Dev->Clip.y1) y = this->Dev->Clip.y1;
+	if(x2 > this->Dev->Clip.x2) x2 = this->Dev->Clip.x2;
+	if(y2 > this->Dev->Clip.y2) y2 = this->Dev->Clip.y2;
+	if(x > x2 || y > y2)
+		return;
+	width = x2 - x;
+	height = y2 - y;
+
+	this->BeginUpdate();
 	height++;
 	
 	pageOffset = y%8;
@@ -350,12 +633,7 @@ void glcd::InvertRect(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
 	 * First do the fractional pages at the top of the region
 	 */
 	glcd_Device::GotoXY(x, y);
-	for(i=0; i<=width; i++) {
-		data = this->ReadData();
-		tmpData = ~data;
-		data = (tmpData & mask) | (data & ~mask);
-		this->WriteData(data);
-	}
+	this->ModifyData(width+1, 0xff, mask);
 	
 	/*
 	 * Now do the full pages
@@ -364,11 +642,7 @@ void glcd::InvertRect(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
 		h += 8;
 		y += 8;
 		glcd_Device::GotoXY(x, y);
-		
-		for(i=0; i<=width; i++) {
-			data = this->ReadData();
-			this->WriteData(~data);
-		}
+		this->ModifyData(width+1, 0xff, 0xff);
 	}
 	
 	/*
@@ -377,14 +651,9 @@ void glcd::InvertRect(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
 	if(h < height) {
 		mask = ~(0xFF << (height-h));
 		glcd_Device::GotoXY(x, y+8);
-		
-		for(i=0; i<=width; i++) {
-			data = this->ReadData();
-			tmpData = ~data;
-			data = (tmpData & mask) | (data & ~mask);
-			this->WriteData(data);
-		}
+		this->ModifyData(width+1, 0xff, mask);
 	}
+	this->EndUpdate();
 }
 /**
  * Set LCD Display mode
@@ -399,9 +668,15 @@ void glcd::InvertRect(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
 
 void glcd::SetDisplayMode(uint8_t invert) {  // was named SetInverted
 
-	if(this->Inverted != invert) {
+	if(this->Dev->Inverted != invert) {
+		lcdClip clip = this->Dev->Clip;
+
+		this->Dev->Clip.x1 = this->Dev->Clip.y1 = 0;	// the entire display, whatever the clip area
+		this->Dev->Clip.x2 = DISPLAY_WIDTH-1;
+		this->Dev->Clip.y2 = DISPLAY_HEIGHT-1;
 		this->InvertRect(0,0,DISPLAY_WIDTH-1,DISPLAY_HEIGHT-1);
-		this->Inverted = invert;
+		this->Dev->Clip = clip;
+		this->Dev->Inverted = invert;
 	}
 }
 
@@ -415,21 +690,36 @@ void glcd::SetDisplayMode(uint8_t invert) {  // was named SetInverted
  *
  * Draws a bitmap image with the upper left corner at location x,y
  * The bitmap data is assumed to be in program memory.
+ * Only the part of the image inside the clip area is drawn,
+ * so x and y can be negative or near the right and bottom edges
+ * to have an image slide on or off the display.
  *
  * Color is optional and defaults to BLACK.
  *
-#ifdef NOTYET
  * @see DrawBitmapXBM()
-#endif
  */
 
-void glcd::DrawBitmap(Image_t bitmap, uint8_t x, uint8_t y, uint8_t color){
+void glcd::DrawBitmap(Image_t bitmap, int16_t x, int16_t y, uint8_t color){
 uint8_t width, height;
-uint8_t i, j;
+uint8_t j, skip, len, mask;
+int16_t by, cx1, cx2;
 
   width = ReadPgmData(bitmap++); 
   height = ReadPgmData(bitmap++);
 
+	/*
+	 * Work out the columns of the image inside the clip area,
+	 * bands of 8 rows above or below it are skipped below.
+	 */
+	cx1 = _GLCD_max(x, this->Dev->Clip.x1);
+	cx2 = x + width - 1 < this->Dev->Clip.x2 ? x + width - 1 : this->Dev->Clip.x2;
+	if(cx1 > cx2 || y > this->Dev->Clip.y2)
+		return;
+	skip = cx1 - x;
+	len = cx2 - cx1 + 1;
+
+	this->BeginUpdate();
+
 #ifdef BITMAP_FIX // temporary ifdef just to show what changes if a new 
 				// bit rendering routine is written.
 							
@@ -458,19 +748,538 @@ uint8_t i, j;
   }
 #endif
 
-  for(j = 0; j < height / 8; j++) {
-     glcd_Device::GotoXY(x, y + (j*8) );
-	 for(i = 0; i < width; i++) {
-		 uint8_t displayData = ReadPgmData(bitmap++);
-	   	 if(color == BLACK)
-			this->WriteData(displayData);
-		 else
-		    this->WriteData(~displayData);
-	 }
+  for(j = 0; j < height / 8; j++, bitmap += width) {
+	by = y + j*8;
+	if(by > this->Dev->Clip.y2)
+		break;
+	if(by + 7 < this->Dev->Clip.y1)
+		continue;
+
+	/*
+	 * the rows of the band inside the clip area
+	 */
+	mask = 0xff;
+	if(by < this->Dev->Clip.y1)
+		mask <<= this->Dev->Clip.y1 - by;
+	if(by + 7 > this->Dev->Clip.y2)
+		mask &= 0xff >> (by + 7 - this->Dev->Clip.y2);
+
+	if(!mask)
+		continue;
+	if(mask == 0xff)
+	{
+		glcd_Device::GotoXY(x + skip, by);
+		this->WriteDataBlock(bitmap + skip, len, ReadPgmData, color);
+	}
+	else
+	{
+		this->BitmapBand(bitmap + skip, len, x + skip, by, mask, color, ReadPgmData);
+	}
   }
+	this->EndUpdate();
+}
+
+/*
+ * Write len columns of a band of 8 bitmap rows with its top row at y,
+ * only changing the rows of the band given by mask.
+ * Each page the band goes through gets a read-modify-write.
+ * The data is read with rdfunc, or directly from RAM if rdfunc is 0.
+ */
+void glcd::BitmapBand(const uint8_t *data, uint8_t len, uint8_t x, int16_t y, uint8_t mask, uint8_t color,
+	DataCallback rdfunc)
+{
+	uint8_t buf[GLCD_BLOCKBUF_SIZE];
+	uint8_t shift = y & 7;
+	uint8_t xorval = color == BLACK ? 0 : 0xff;
+	uint8_t page, pmask, i, n, d;
+
+	for(page = 0; page < 2; page++)
+	{
+		pmask = page ? mask >> (8 - shift) : mask << shift;
+		if(!pmask || (y & ~7) + page*8 >= DISPLAY_HEIGHT)
+			continue;
+		glcd_Device::GotoXY(x, (y & ~7) + page*8);
+		for(i = 0; i < len; i += n)
+		{
+			n = len - i < (int16_t)sizeof(buf) ? len - i : sizeof(buf);
+			this->ReadDataBlock(buf, n);
+			for(uint8_t j = 0; j < n; j++)
+			{
+				d = (rdfunc ? rdfunc(data + i + j) : data[i + j]) ^ xorval;
+				d = page ? d >> (8 - shift) : d << shift;
+				buf[j] = (buf[j] & ~pmask) | (d & pmask);
+			}
+			this->WriteDataBlock(buf, n);
+		}
+	}
+}
+
+/**
+ * Draw a run length encoded glcd bitmap image
+ *
+ * @param bitmap a ponter to the run length encoded bitmap data
+ * @param x the x coordinate of the upper left corner of the bitmap
+ * @param y the y coordinate of the upper left corner of the bitmap
+ * @param color BLACK or WHITE
+ *
+ * Draws the image exactly like DrawBitmap() would draw it before it was encoded,
+ * except that the rows of the last band past the image height are left alone.
+ * The encoded data is 1 byte of width, 1 byte of height, then runs that
+ * together make up the bytes of the glcd bitmap in the same order as DrawBitmap() data,
+ * each starting with a code byte:
+ *
+ * @b 0x00-0x7F the next code+1 bytes (1 to 128) are image bytes.@n
+ * @b 0x80-0xBF the next byte is repeated (code&0x3F)+1 times (1 to 64).@n
+ * @b 0xC0-0xFF the next (code&0x3F)+1 bytes are left as they are on the display.
+ *
+ * Runs can carry on from one band of 8 rows to the next.
+ * The runs are decoded as they are drawn and go straight to the display as blocks of data,
+ * so blank areas and areas of one pattern take less program memory and draw as fast as
+ * DrawBitmap().
+ * Skipped bytes are not written at all, which lets an image be drawn as the changes
+ * from one that is already on the display.
+ *
+ * Only the part of the image inside the clip area is drawn.
+ * The bitmap data is assumed to be in program memory.
+ *
+ * Color is optional and defaults to BLACK.
+ *
+ * @see DrawBitmap()
+ */
+
+void glcd::DrawBitmapRLE(ImageRLE_t bitmap, int16_t x, int16_t y, uint8_t color)
+{
+	this->DrawRuns(bitmap + 2, ReadPgmData(bitmap), ReadPgmData(bitmap + 1), x, y, color);
+}
+
+/*
+ * Draw the runs of a width by height run length encoded image at x,y, see DrawBitmapRLE()
+ */
+void glcd::DrawRuns(const uint8_t *runs, uint8_t width, uint8_t height, int16_t x, int16_t y, uint8_t color)
+{
+uint8_t buf[GLCD_BLOCKBUF_SIZE];
+uint8_t bands, band, mask, code, run, col, n, len, i;
+int16_t by, cx1, cx2, c1, c2;
+const uint8_t *src;
+DataCallback rdfunc;
+
+	bands = (height + 7) / 8;
+
+	cx1 = _GLCD_max(x, this->Dev->Clip.x1);
+	cx2 = x + width - 1 < this->Dev->Clip.x2 ? x + width - 1 : this->Dev->Clip.x2;
+	if(cx1 > cx2 || y > this->Dev->Clip.y2)
+		return;
+
+	this->BeginUpdate();
+	code = run = 0;
+	for(band = 0; band < bands; band++)
+	{
+		by = y + band*8;
+		if(by > this->Dev->Clip.y2)
+			break;
+
+		/*
+		 * the rows of the band inside the clip area and the image,
+		 * the runs of a band outside of them still have to be decoded
+		 */
+		mask = 0;
+		if(by + 7 >= this->Dev->Clip.y1)
+		{
+			mask = 0xff;
+			if(by < this->Dev->Clip.y1)
+				mask <<= this->Dev->Clip.y1 - by;
+			if(by + 7 > this->Dev->Clip.y2)
+				mask &= 0xff >> (by + 7 - this->Dev->Clip.y2);
+			if(band == bands - 1 && (height & 7))
+				mask &= 0xff >> (8 - (height & 7));
+		}
+
+		for(col = 0; col < width; col += n)
+		{
+			if(!run)
+			{
+				code = ReadPgmData(runs++);
+				run = (code & (code & 0x80 ? 0x3f : 0x7f)) + 1;
+			}
+			n = run < width - col ? run : width - col;
+			run -= n;
+
+			/*
+			 * the columns of this part of the run inside the clip area
+			 */
+			c1 = _GLCD_max(x + col, cx1);
+			c2 = x + col + n - 1 < cx2 ? x + col + n - 1 : cx2;
+			if(mask && c1 <= c2 && (code & 0xc0) != 0xc0)
+			{
+				len = c2 - c1 + 1;
+				if(code & 0x80)
+				{
+					for(i = 0; i < sizeof(buf) && i < len; i++)
+						buf[i] = ReadPgmData(runs);
+					src = buf;
+					rdfunc = 0;
+				}
+				else
+				{
+					src = runs + (c1 - x - col);
+					rdfunc = ReadPgmData;
+				}
+				while(len)
+				{
+					i = rdfunc || len < sizeof(buf) ? len : sizeof(buf);
+					if(mask == 0xff && !(by & 7))
+					{
+						glcd_Device::GotoXY(c1, by);
+						this->WriteDataBlock(src, i, rdfunc, color);
+					}
+					else
+					{
+						this->BitmapBand(src, i, c1, by, mask, color, rdfunc);
+					}
+					if(rdfunc)
+						src += i;
+					c1 += i;
+					len -= i;
+				}
+			}
+			if(!(code & 0x80))
+				runs += n;			// past the image bytes
+			else if(!run && !(code & 0x40))
+				runs++;				// past the repeated byte
+		}
+	}
+	this->EndUpdate();
+}
+
+/**
+ * Draw the next frame of an animation when it is due
+ *
+ * @param anim the animation
+ * @return 1 if a frame was drawn, 0 if the next one is not due yet
+ *
+ * Call it as often as the sketch can, from loop() for example,
+ * and the frames are drawn at the rate given in the animation data.
+ * The first call after the animation is made or restarted draws frame 0 in full
+ * straight away, after that each frame is drawn as the bytes that changed since the one before.
+ * Frames are never dropped, since the changes only make sense in order:
+ * if the sketch falls more than a frame behind, the timing starts again from the late frame.
+ *
+ * @see glcd_Animation
+ * @see DrawBitmapRLE()
+ */
+
+uint8_t glcd::PlayAnimation(glcd_Animation &anim)
+{
+	uint16_t interval = ReadPgmData(anim.Anim + 3) | ReadPgmData(anim.Anim + 4) << 8;
+	unsigned long now = millis();
+
+	if(anim.Frame)
+	{
+		if(now - anim.Time < interval)
+			return(0);
+		anim.Time += interval;
+		if(now - anim.Time >= interval)
+			anim.Time = now;
+	}
+	else
+	{
+		anim.Time = now;
+	}
+
+	this->DrawRuns(anim.Next + 2, ReadPgmData(anim.Anim), ReadPgmData(anim.Anim + 1), anim.X, anim.Y, anim.Color);
+	anim.Next += 2 + (ReadPgmData(anim.Next) | ReadPgmData(anim.Next + 1) << 8);
+
+	/*
+	 * after the changes back to frame 0 comes frame 1 again
+	 */
+	if(anim.Frame++ == ReadPgmData(anim.Anim + 2))
+	{
+		anim.Next = anim.Anim + 5;
+		anim.Next += 2 + (ReadPgmData(anim.Next) | ReadPgmData(anim.Next + 1) << 8);
+		anim.Frame = 1;
+	}
+	return(1);
+}
+
+/**
+ * Get ready to play an animation
+ *
+ * @param anim the animation data made by the bitmap tool, in program memory
+ * @param x the x coordinate of the upper left corner of the frames
+ * @param y the y coordinate of the upper left corner of the frames
+ * @param color BLACK or WHITE
+ *
+ * @see glcd::PlayAnimation()
+ */
+glcd_Animation::glcd_Animation(ImageAnim_t anim, int16_t x, int16_t y, uint8_t color)
+{
+	this->Anim = anim;
+	this->X = x;
+	this->Y = y;
+	this->Color = color;
+	this->Restart();
+}
+
+/**
+ * Start the animation again from frame 0
+ *
+ * The next glcd::PlayAnimation() draws frame 0 in full,
+ * which also repairs the animation if something was drawn over it.
+ */
+void glcd_Animation::Restart(void)
+{
+	this->Next = this->Anim + 5;
+	this->Frame = 0;
+	this->Time = 0;
+}
+
+/*
+ * The bits of column col of a glcd format image that land on the display page
+ * holding image rows 8*band-shift to 8*band-shift+7
+ * (band 0 being the page the top of the image is on).
+ * That is the bottom of the image band above shifted up plus the top of
+ * the image band shifted down, bands past the bottom of the image are 0.
+ * The image is read with rdfunc, or directly from RAM if rdfunc is 0.
+ */
+static uint8_t glcd_SpriteByte(const uint8_t *data, DataCallback rdfunc, uint8_t width, uint8_t bands,
+	uint8_t band, uint8_t shift, uint8_t col)
+{
+	uint8_t d = 0;
+	const uint8_t *p = data + band*width + col;
+
+	if(band < bands)
+		d = (rdfunc ? rdfunc(p) : *p) << shift;
+	if(shift && band)
+	{
+		p -= width;
+		d |= (rdfunc ? rdfunc(p) : *p) >> (8 - shift);
+	}
+	return(d);
+}
+
+/**
+ * Draw a sprite
+ *
+ * @param sprite a pointer to the glcd format bitmap of the sprite
+ * @param x the x coordinate of the upper left corner of the sprite
+ * @param y the y coordinate of the upper left corner of the sprite
+ * @param mode how the sprite is combined with what is already on the display
+ * @param mask a glcd format bitmap the same size as the sprite, only used by SPRITE_MASKED
+ *
+ * Draws a glcd format bitmap with the upper left corner at location x,y
+ * combining it with the pixels already on the display according to @em mode:
+ *
+ * @b SPRITE_OPAQUE sets every pixel of the sprite as it is in the bitmap.@n
+ * @b SPRITE_OR sets the pixels of the 1 bits of the bitmap BLACK.@n
+ * @b SPRITE_ANDNOT sets the pixels of the 1 bits of the bitmap WHITE.@n
+ * @b SPRITE_XOR inverts the pixels of the 1 bits of the bitmap.@n
+ * @b SPRITE_MASKED sets the pixels of the 1 bits of the mask as they are in the bitmap
+ * and leaves the rest, so the sprite can have transparent areas of any shape.
+ * With no mask it is the same as SPRITE_OPAQUE.
+ *
+ * Unlike DrawBitmap(), the height can be any value, y does not have to be a multiple
+ * of 8 and there is no need to clear the area first:
+ * the bitmap columns are shifted to line up with the display pages and each page
+ * of the display the sprite covers is written exactly once, reading it first only
+ * when some of its pixels have to be kept.
+ * So a sprite can be moved by drawing it again, without flicker.
+ *
+ * Only the part of the sprite inside the clip area is drawn.
+ * The bitmap data and mask are assumed to be in program memory.
+ *
+ * @see DrawBitmap()
+ * @see glcd_SpriteCache
+ */
+
+void glcd::DrawSprite(Image_t sprite, int16_t x, int16_t y, spriteMode mode, Image_t mask)
+{
+	uint8_t height = ReadPgmData(sprite + 1);
+
+	this->SpriteBlit(sprite + 2, mask ? mask + 2 : 0, ReadPgmData, ReadPgmData(sprite), height,
+		(height + 7) / 8, y & 7, x, y, mode);
+}
+
+/**
+ * Draw a sprite from its pre-shifted copies
+ *
+ * @param sprite the pre-shifted copies of the sprite
+ * @param x the x coordinate of the upper left corner of the sprite
+ * @param y the y coordinate of the upper left corner of the sprite
+ * @param mode how the sprite is combined with what is already on the display
+ *
+ * Draws the sprite exactly like DrawSprite(Image_t sprite, int16_t x, int16_t y, spriteMode mode, Image_t mask)
+ * but from the copy already shifted for y, making it first if it is not in RAM.
+ *
+ * @see glcd_SpriteCache
+ */
+
+void glcd::DrawSprite(glcd_SpriteCache &sprite, int16_t x, int16_t y, spriteMode mode)
+{
+	uint8_t shift = y & 7;
+	uint8_t bands = (sprite.Height + 14) / 8;
+	uint8_t slot, band, col;
+	const uint8_t *copy;
+	uint8_t *p;
+
+	if(sprite.Buf)
+	{
+		if(!sprite.Slots)
+		{
+			this->DrawSprite(sprite.Sprite, x, y, mode, sprite.Mask);	// no room for a copy
+			return;
+		}
+		slot = shift % sprite.Slots;
+		p = sprite.Buf + slot * sprite.Size;
+		if(sprite.Shift[slot] != shift)
+		{
+			for(band = 0; band < bands; band++)
+				for(col = 0; col < sprite.Width; col++)
+				{
+					*p = glcd_SpriteByte(sprite.Sprite + 2, ReadPgmData, sprite.Width,
+						(sprite.Height + 7) / 8, band, shift, col);
+					if(sprite.Mask)
+						p[bands * sprite.Width] = glcd_SpriteByte(sprite.Mask + 2, ReadPgmData, sprite.Width,
+							(sprite.Height + 7) / 8, band, shift, col);
+					p++;
+				}
+			sprite.Shift[slot] = shift;
+		}
+		copy = sprite.Buf + slot * sprite.Size;
+	}
+	else
+	{
+		copy = sprite.Copies + 3 + shift * sprite.Size;
+	}
+	this->SpriteBlit(copy, sprite.Mask ? copy + bands * sprite.Width : 0, sprite.Buf ? 0 : ReadPgmData,
+		sprite.Width, sprite.Height, bands, 0, x, y, mode);
+}
+
+/*
+ * Combine a sprite at x,y with the display, see DrawSprite().
+ * data (and mask) are bands of width bytes read with rdfunc (directly from RAM if rdfunc is 0),
+ * band 0 being the bits for the page holding y shifted down by shift.
+ * A pre-shifted copy has its shift built in, so shift is 0 and bands are just copied.
+ */
+void glcd::SpriteBlit(const uint8_t *data, const uint8_t *mask, DataCallback rdfunc, uint8_t width, uint8_t height,
+	uint8_t bands, uint8_t shift, int16_t x, int16_t y, spriteMode mode)
+{
+uint8_t buf[GLCD_BLOCKBUF_SIZE];
+uint8_t cover, band, n, i, col, s, m;
+int16_t cx1, cx2, cy1, cy2, py, c;
+
+	if(!mask && mode == SPRITE_MASKED)
+		mode = SPRITE_OPAQUE;
+
+	/*
+	 * the part of the sprite inside the clip area
+	 */
+	cx1 = _GLCD_max(x, this->Dev->Clip.x1);
+	cx2 = x + width - 1 < this->Dev->Clip.x2 ? x + width - 1 : this->Dev->Clip.x2;
+	cy1 = _GLCD_max(y, this->Dev->Clip.y1);
+	cy2 = y + height - 1 < this->Dev->Clip.y2 ? y + height - 1 : this->Dev->Clip.y2;
+	if(cx1 > cx2 || cy1 > cy2)
+		return;
+
+	this->BeginUpdate();
+	for(py = cy1 & ~7; py <= cy2; py += 8)
+	{
+		/*
+		 * the rows of this page the sprite covers
+		 */
+		cover = 0xff;
+		if(py < cy1)
+			cover <<= cy1 - py;
+		if(py + 7 > cy2)
+			cover &= 0xff >> (py + 7 - cy2);
+		band = (py - (y & ~7)) / 8;
+
+		if(mode == SPRITE_OPAQUE && cover == 0xff && !shift)
+		{
+			/*
+			 * the whole page is the band as it is
+			 */
+			glcd_Device::GotoXY(cx1, py);
+			this->WriteDataBlock(data + band*width + (cx1 - x), cx2 - cx1 + 1, rdfunc);
+			continue;
+		}
+
+		for(c = cx1; c <= cx2; c += n)
+		{
+			n = cx2 - c + 1 < (int16_t)sizeof(buf) ? cx2 - c + 1 : sizeof(buf);
+			glcd_Device::GotoXY(c, py);
+			if(mode != SPRITE_OPAQUE || cover != 0xff)
+				this->ReadDataBlock(buf, n);
+
+			/*
+			 * Each byte becomes (byte & ~m) ^ (s & m) where m is the pixels changed,
+			 * except XOR which leaves the pixels and ANDNOT which sets them WHITE.
+			 */
+			col = c - x;
+			for(i = 0; i < n; i++, col++)
+			{
+				s = glcd_SpriteByte(data, rdfunc, width, bands, band, shift, col);
+				if(mode == SPRITE_OPAQUE)
+					m = cover;
+				else if(mode == SPRITE_MASKED)
+					m = glcd_SpriteByte(mask, rdfunc, width, bands, band, shift, col) & cover;
+				else
+					m = s & cover;
+				if(mode != SPRITE_XOR)
+					buf[i] &= ~m;
+				if(mode != SPRITE_ANDNOT)
+					buf[i] ^= s & m;
+			}
+			this->WriteDataBlock(buf, n);
+		}
+	}
+	this->EndUpdate();
 }
 
-#ifdef NOTYET
+/**
+ * Keep pre-shifted copies of a sprite in RAM
+ *
+ * @param sprite a pointer to the glcd format bitmap of the sprite in program memory
+ * @param buf RAM for the copies
+ * @param bufsize size of buf in bytes, up to 8 copies of GLCD_SPRITE_COPYSIZE() are used
+ * @param mask the mask of the sprite for SPRITE_MASKED, or 0
+ *
+ * @see glcd::DrawSprite()
+ */
+glcd_SpriteCache::glcd_SpriteCache(Image_t sprite, uint8_t *buf, uint16_t bufsize, Image_t mask)
+{
+	this->Sprite = sprite;
+	this->Mask = mask;
+	this->Buf = buf;
+	this->Copies = 0;
+	this->Width = ReadPgmData(sprite);
+	this->Height = ReadPgmData(sprite + 1);
+	this->Size = GLCD_SPRITE_COPYSIZE(this->Width, this->Height, mask);
+	this->Slots = 0;
+	if(this->Size)
+		this->Slots = bufsize / this->Size < 8 ? bufsize / this->Size : 8;
+	for(uint8_t i = 0; i < 8; i++)
+		this->Shift[i] = 0xff;
+}
+
+/**
+ * Use pre-shifted copies of a sprite made ahead of time
+ *
+ * @param shifted a pointer to the copies in program memory, see glcd_SpriteCache
+ *
+ * The copies have no use for the original bitmap,
+ * a mask if there is one is part of the copies.
+ */
+glcd_SpriteCache::glcd_SpriteCache(Image_t shifted)
+{
+	this->Copies = shifted;
+	this->Buf = 0;
+	this->Slots = 0;
+	this->Width = ReadPgmData(shifted);
+	this->Height = ReadPgmData(shifted + 1);
+	this->Sprite = 0;
+	this->Mask = ReadPgmData(shifted + 2) ? shifted : 0;		// only tested for being there
+	this->Size = GLCD_SPRITE_COPYSIZE(this->Width, this->Height, this->Mask);
+}
 
 /**
  * Draw a glcd bitmap image in x11 XBM bitmap data format
@@ -491,14 +1300,14 @@ uint8_t i, j;
  * @see DrawBitmap()
  */
 
-void glcd::DrawBitmapXBM(ImageXBM_t bitmapxbm, uint8_t x, uint8_t y, uint8_t color)
+void glcd::DrawBitmapXBM(ImageXBM_t bitmapxbm, int16_t x, int16_t y, uint8_t color)
 {
 uint8_t width, height;
 uint8_t bg_color;
-uint8_t *xbmbits;
+const uint8_t *xbmbits;
 
 	
-	xbmbits = (uint8_t *) bitmapxbm;
+	xbmbits = bitmapxbm;
 
 	width = ReadPgmData(xbmbits++); 
 	height = ReadPgmData(xbmbits++);
@@ -525,53 +1334,109 @@ uint8_t *xbmbits;
  * The xbm bitmap pixel data format is the same as the X11 bitmap pixel data.
  * The bitmap data is assumed to be in program memory.
  *
+ * Like DrawSprite() the image can be any height and at any y,
+ * each page of the display it covers is written once, and only read first
+ * when the image does not cover all 8 rows of it.
+ * Only the part of the image inside the clip area is drawn.
+ *
  * @note All parameters are mandatory
  *
- * @see DrawBitmapXBM_P()
+ * @see DrawBitmapXBM()
  * @see DrawBitmap()
  */
 
 
-void glcd::DrawBitmapXBM_P(uint8_t width, uint8_t height, uint8_t *xbmbits, 
-			uint8_t x, uint8_t y, uint8_t fg_color, uint8_t bg_color)
+void glcd::DrawBitmapXBM_P(uint8_t width, uint8_t height, const uint8_t *xbmbits, 
+			int16_t x, int16_t y, uint8_t fg_color, uint8_t bg_color)
 {
-uint8_t xbmx, xbmy;
-uint8_t xbmdata;
+uint8_t buf[GLCD_BLOCKBUF_SIZE];
+uint8_t rows[8];
+uint8_t stride = (width + 7) / 8;
+uint8_t xorval = fg_color == BLACK ? 0 : 0xff;
+uint8_t cover, n, i, k, col, d;
+int16_t cx1, cx2, cy1, cy2, py, c;
 
 	/*
-	 * Traverse through the XBM data byte by byte and plot pixel by pixel
+	 * the part of the image inside the clip area
 	 */
-	for(xbmy = 0; xbmy < height; xbmy++)
+	cx1 = _GLCD_max(x, this->Dev->Clip.x1);
+	cx2 = x + width - 1 < this->Dev->Clip.x2 ? x + width - 1 : this->Dev->Clip.x2;
+	cy1 = _GLCD_max(y, this->Dev->Clip.y1);
+	cy2 = y + height - 1 < this->Dev->Clip.y2 ? y + height - 1 : this->Dev->Clip.y2;
+	if(cx1 > cx2 || cy1 > cy2)
+		return;
+
+	this->BeginUpdate();
+	for(py = cy1 & ~7; py <= cy2; py += 8)
 	{
-		for(xbmx = 0; xbmx < width; xbmx++)
-		{
-			if(!(xbmx & 7))	// read the flash data only once per byte
-				xbmdata = ReadPgmData(xbmbits++);
+		/*
+		 * the rows of this page the image covers
+		 */
+		cover = 0xff;
+		if(py < cy1)
+			cover <<= cy1 - py;
+		if(py + 7 > cy2)
+			cover &= 0xff >> (py + 7 - cy2);
 
-			if(xbmdata & _BV((xbmx & 7)))
-				this->SetDot(x+xbmx, y+xbmy, fg_color); // XBM 1 bits are fg color
-			else
-				this->SetDot(x+xbmx, y+xbmy, bg_color); // XBM 0 bits are bg color
+		for(c = cx1; c <= cx2; c += n)
+		{
+			n = cx2 - c + 1 < (int16_t)sizeof(buf) ? cx2 - c + 1 : sizeof(buf);
+			glcd_Device::GotoXY(c, py);
+			if(cover != 0xff)
+				this->ReadDataBlock(buf, n);
+
+			/*
+			 * An xbm byte is 8 pixels of a row with the leftmost in bit 0.
+			 * The xbm bytes of the 8 rows on this page are read once and
+			 * transposed into the page bytes of their 8 columns,
+			 * shifting a bit out of each row for each column.
+			 */
+			col = c - x;
+			for(i = 0; i < n; )
+			{
+				for(k = 0; k < 8; k++)
+				{
+					rows[k] = 0;
+					if(cover & _BV(k))
+						rows[k] = ReadPgmData(xbmbits + (py - y + k) * stride + col / 8) >> (col & 7);
+				}
+				do
+				{
+					d = 0;
+					for(k = 8; k--; )
+					{
+						d = (d << 1) | (rows[k] & 1);
+						rows[k] >>= 1;
+					}
+					if(fg_color == bg_color)
+						d = fg_color;
+					else
+						d ^= xorval;
+					buf[i] = (buf[i] & ~cover) | (d & cover);
+					i++;
+					col++;
+				} while(i < n && (col & 7));
+			}
+			this->WriteDataBlock(buf, n);
 		}
 	}
-
+	this->EndUpdate();
 }
 
-#endif // NOTYET
-
 // the following inline functions were added 2 Dec 2009 to replace macros
 
 /**
  * Draw a Vertical Line
  *
- * @param x a value from 0 to GLCD.Width-1
- * @param y a value from 0 to GLCD.Height-1
+ * @param x x coordinate of the top of the line
+ * @param y y coordinate of the top of the line
  * @param height a value from 1 to GLCD.Height-y-1
  * @param color color of line
  *
  * color of BLACK or WHITE is an optional parameter indicating pixel color, default is BLACK
  *
  * The line drawn will be height+1 pixels.
+ * Any part of it off the display is not drawn.
  *
  * @note This function was previously named DrawVertLine() in the ks0108 library
  *
@@ -580,7 +1445,7 @@ uint8_t xbmdata;
  */
  
 
-void glcd::DrawVLine(uint8_t x, uint8_t y, uint8_t height, uint8_t color){
+void glcd::DrawVLine(int16_t x, int16_t y, uint8_t height, uint8_t color){
   // this->FillRect(x, y, 0, length, color);
    this->SetPixels(x,y,x,y+height,color);
 }
@@ -588,12 +1453,13 @@ void glcd::DrawVLine(uint8_t x, uint8_t y, uint8_t height, uint8_t color){
 /**
  * Draw a Horizontal Line
  *
- * @param x a value from 0 to GLCD.Width-1
- * @param y a value from 0 to GLCD.Height-1
+ * @param x x coordinate of the left end of the line
+ * @param y y coordinate of the left end of the line
  * @param width a value from 1 to GLCD.Width-x-1
  * @param color BLACK or WHITE 
  *
  * The line drawn will be width+1 pixels.
+ * Any part of it off the display is not drawn.
  *
  * color is an optional parameter indicating pixel color and defaults to BLACK
  *
@@ -603,7 +1469,7 @@ void glcd::DrawVLine(uint8_t x, uint8_t y, uint8_t height, uint8_t color){
  * @see DrawVLine()
  */
 
-void glcd::DrawHLine(uint8_t x, uint8_t y, uint8_t width, uint8_t color){
+void glcd::DrawHLine(int16_t x, int16_t y, uint8_t width, uint8_t color){
    // this->FillRect(x, y, length, 0, color);
     this->SetPixels(x,y, x+width, y, color);
 }
@@ -628,7 +1494,7 @@ void glcd::DrawHLine(uint8_t x, uint8_t y, uint8_t width, uint8_t color){
  *
  * @see FillCircle()
  */
-void glcd::DrawCircle(uint8_t xCenter, uint8_t yCenter, uint8_t radius, uint8_t color){
+void glcd::DrawCircle(int16_t xCenter, int16_t yCenter, uint8_t radius, uint8_t color){
    this->DrawRoundRect(xCenter-radius, yCenter-radius, 2*radius, 2*radius, radius, color);
 }
 
@@ -651,7 +1517,7 @@ void glcd::DrawCircle(uint8_t xCenter, uint8_t yCenter, uint8_t radius, uint8_t
  *
  */
 
-void glcd::FillCircle(uint8_t xCenter, uint8_t yCenter, uint8_t radius, uint8_t color)
+void glcd::FillCircle(int16_t xCenter, int16_t yCenter, uint8_t radius, uint8_t color)
 {
 /*
  * Circle fill Code is merely a modification of the midpoint
@@ -686,11 +1552,16 @@ int ddF_x = 1;
 int ddF_y = -2 * radius;
 uint8_t x = 0;
 uint8_t y = radius;
+uint8_t x0 = 1;
  
+	if(_GLCD_outcode(xCenter-radius, yCenter-radius) & _GLCD_outcode(xCenter+radius, yCenter+radius))
+		return;		// entirely outside the clip area
+
+	this->BeginUpdate();
 	/*
 	 * Fill in the center between the two halves
 	 */
-	DrawLine(xCenter, yCenter-radius, xCenter, yCenter+radius, color);
+	this->ColumnSpans(xCenter, xCenter, yCenter-radius, yCenter+radius, color);
  
 	while(x < y)
 	{
@@ -711,13 +1582,128 @@ uint8_t y = radius;
 		 * Now draw vertical lines between the points on the circle rather than
 		 * draw the points of the circle. This draws lines between the 
 		 * perimeter points on the upper and lower quadrants of the 2 halves of the circle.
+		 *
+		 * Nothing is drawn until y is about to step (f >= 0) or the loop ends.
+		 * By then the columns at xCenter+/-x0 through xCenter+/-x all have
+		 * the same height so they are filled together, and the columns at xCenter+/-y
+		 * (which get a little taller on each pass) have reached their final height.
 		 */
 
-		DrawLine(xCenter+x, yCenter+y, xCenter+x, yCenter-y, color);
-		DrawLine(xCenter-x, yCenter+y, xCenter-x, yCenter-y, color);
-		DrawLine(xCenter+y, yCenter+x, y+xCenter, yCenter-x, color);
-		DrawLine(xCenter-y, yCenter+x, xCenter-y, yCenter-x, color);
+		if(f >= 0 || x >= y)
+		{
+			this->ColumnSpans(xCenter+x0, xCenter+x, yCenter-y, yCenter+y, color);
+			this->ColumnSpans(xCenter-x, xCenter-x0, yCenter-y, yCenter+y, color);
+			this->ColumnSpans(xCenter+y, xCenter+y, yCenter-x, yCenter+x, color);
+			this->ColumnSpans(xCenter-y, xCenter-y, yCenter-x, yCenter+x, color);
+			x0 = x+1;
+		}
   	}
+	this->EndUpdate();
+}
+
+/**
+ * Draw a Filled in Ellipse
+ *
+ * @param xCenter X coordinate of the center of the ellipse
+ * @param yCenter Y coordinate of the center of the ellipse
+ * @param xRadius horizontal radius of the ellipse (0-127)
+ * @param yRadius vertical radius of the ellipse (0-127)
+ * @param color WHITE or BLACK
+ *
+ * Draws a filled in ellipse extending out from the center pixel.
+ * The ellipse will fit inside a rectanglular area bounded by
+ * x-xRadius,y-yRadius and x+xRadius,y+yRadius
+ * so it is 2 * xRadius +1 pixels wide and 2 * yRadius +1 pixels high.
+ *
+ * Parts of the ellipse that are off the display are not drawn.
+ *
+ * Color is optional and defaults to BLACK.
+ *
+ * @see FillCircle()
+ */
+
+void glcd::FillEllipse(int16_t xCenter, int16_t yCenter, uint8_t xRadius, uint8_t yRadius, uint8_t color)
+{
+/*
+ * The ellipse is filled one column at a time, each column being
+ * a single vertical span from yCenter-h to yCenter+h.
+ * For column xCenter+/-x, h is the largest value for which the point
+ * half a pixel below it is still inside the ellipse:
+ *
+ *	b*b*x*x + a*a*(h-1/2)*(h-1/2) <= a*a*b*b
+ *
+ * which is kept in integers by multiplying through by 4:
+ *
+ *	a*a*(2h-1)*(2h-1) <= 4*b*b*(a*a - x*x)
+ *
+ * Both sides are only ever stepped down (h and a*a - x*x both shrink as x grows)
+ * so no multiplies are needed inside the loop.
+ * The radii are limited to 127 to keep the terms in 32 bits.
+ */
+uint8_t a = xRadius > 127 ? 127 : xRadius;
+uint8_t b = yRadius > 127 ? 127 : yRadius;
+uint32_t aa = (uint32_t)a * a;
+uint32_t bb4 = 4 * (uint32_t)b * b;
+uint32_t lhs = aa * (2*b-1) * (2*b-1);	// a*a*(2h-1)^2 for h == b
+uint32_t rhs = bb4 * aa;				// 4*b*b*(a*a - x*x) for x == 0
+uint8_t h = b;
+uint8_t x = 0;
+uint8_t x0 = 0;
+
+	if(b == 0)
+		lhs = aa;		// (2h-1)^2 is 1 for h == 0
+
+	if(_GLCD_outcode(xCenter-a, yCenter-b) & _GLCD_outcode(xCenter+a, yCenter+b))
+		return;		// entirely outside the clip area
+
+	this->BeginUpdate();
+	for(;;)
+	{
+		while(h && lhs > rhs)
+		{
+			lhs -= aa * 8 * (h-1);	// (2h-1)^2 - (2h-3)^2 == 8h-8
+			h--;
+		}
+		if(x == a)
+			break;
+		rhs -= bb4 * (2*x+1);		// x*x - (x+1)*(x+1) == -(2x+1)
+		x++;
+
+		/*
+		 * Columns of the same height are filled together once the height changes.
+		 */
+		if(h && lhs > rhs)
+		{
+			this->ColumnSpans(xCenter+x0, xCenter+x-1, yCenter-h, yCenter+h, color);
+			this->ColumnSpans(xCenter-x+1, xCenter-(x0 ? x0 : 1), yCenter-h, yCenter+h, color);
+			x0 = x;
+		}
+	}
+	this->ColumnSpans(xCenter+x0, xCenter+x, yCenter-h, yCenter+h, color);
+	this->ColumnSpans(xCenter-x, xCenter-(x0 ? x0 : 1), yCenter-h, yCenter+h, color);
+	this->EndUpdate();
+}
+
+/*
+ * Fill the pixels from y1 to y2 in columns x1 through x2, clipped to the clip area.
+ * SetPixels() does this with a read-modify-write of the partial page
+ * at each end and a plain write of each whole page in between.
+ */
+void glcd::ColumnSpans(int16_t x1, int16_t x2, int16_t y1, int16_t y2, uint8_t color)
+{
+	if(x1 < this->Dev->Clip.x1)
+		x1 = this->Dev->Clip.x1;
+	if(x2 > this->Dev->Clip.x2)
+		x2 = this->Dev->Clip.x2;
+	if(x1 > x2)
+		return;
+	if(y1 < this->Dev->Clip.y1)
+		y1 = this->Dev->Clip.y1;
+	if(y2 > this->Dev->Clip.y2)
+		y2 = this->Dev->Clip.y2;
+	if(y1 > y2)
+		return;
+	this->SetPixels(x1, y1, x2, y2, color);
 }
 
 	
@@ -48,11 +48,107 @@
  */
 typedef const uint8_t* Image_t; // a glcd format bitmap (includes width & height)
 typedef const uint8_t* ImageXBM_t; // a "xbm" format bitmap (includes width & height)
+typedef const uint8_t* ImageRLE_t; // a run length encoded glcd bitmap (includes width & height)
+typedef const uint8_t* ImageAnim_t; // run length encoded animation frames (includes width, height, frames & rate)
 
 // the first two bytes of bitmap data are the width and height
 #define bitmapWidth(bitmap)  (*bitmap)  
 #define bitmapHeight(bitmap)  (*(bitmap+1))  
 
+typedef uint8_t spriteMode;  // how DrawSprite() combines a sprite with the display
+
+const spriteMode SPRITE_OPAQUE = 0;	// copy the sprite, its 0 bits become WHITE
+const spriteMode SPRITE_OR = 1;		// 1 bits set their pixels BLACK, 0 bits leave them
+const spriteMode SPRITE_ANDNOT = 2;	// 1 bits set their pixels WHITE, 0 bits leave them
+const spriteMode SPRITE_XOR = 3;	// 1 bits invert their pixels, 0 bits leave them
+const spriteMode SPRITE_MASKED = 4;	// copy the sprite where its mask has 1 bits, leave the rest
+
+/*
+ * bytes of RAM for one pre-shifted copy of a sprite, see glcd_SpriteCache
+ */
+#define GLCD_SPRITE_COPYSIZE(width, height, masked) ((width) * (((height) + 14) / 8) * ((masked) ? 2 : 1))
+
+/**
+ * @class glcd_SpriteCache
+ * @brief Pre-shifted copies of a sprite for DrawSprite()
+ *
+ * Drawing a sprite at a y that is not a multiple of 8 shifts every
+ * column of it into line with the display pages.
+ * A sprite that is redrawn every frame can keep a copy of itself shifted
+ * for each y%8 it gets drawn at, then drawing it is only page aligned copies.
+ *
+ * The copies go in RAM supplied by the sketch and are made the first time
+ * they are needed. The RAM holds up to 8 copies of GLCD_SPRITE_COPYSIZE() bytes,
+ * with fewer the copies for different shifts take turns:
+ *
+ *	uint8_t rockCopies[8 * GLCD_SPRITE_COPYSIZE(12, 8, false)];
+ *	glcd_SpriteCache rockSprite(rock, rockCopies, sizeof(rockCopies));
+ *	GLCD.DrawSprite(rockSprite, x, y);
+ *
+ * The copies can also be made ahead of time by the bitmap tool and kept in flash,
+ * that data starts with the width, height and a 1 if there is a mask (0 if not)
+ * followed by the 8 copies for shifts 0 to 7. A copy is (height+14)/8 bands
+ * of width bytes with the top of the sprite on row shift of band 0,
+ * followed by the same for the mask if there is one.
+ */
+class glcd_SpriteCache
+{
+  public:
+	glcd_SpriteCache(Image_t sprite, uint8_t *buf, uint16_t bufsize, Image_t mask = 0);
+	glcd_SpriteCache(Image_t shifted);
+
+	Image_t		Sprite;		// the glcd format bitmap of the sprite
+	Image_t		Mask;		// its mask, or 0
+	uint8_t		*Buf;		// RAM for the copies, or 0 when they are in flash
+	Image_t		Copies;		// the copies made ahead of time in flash
+	uint16_t	Size;		// bytes in one copy
+	uint8_t		Width;
+	uint8_t		Height;
+	uint8_t		Slots;		// copies that fit in Buf
+	uint8_t		Shift[8];	// the shift of the copy in each slot, 0xff if it is empty
+};
+
+/**
+ * @class glcd_Animation
+ * @brief An animation being played by PlayAnimation()
+ *
+ * An animation is drawn as its first frame and after that as only the
+ * bytes that change from each frame to the next, so the time it takes
+ * depends on how much moves rather than on the size of the frames:
+ *
+ *	glcd_Animation spinner(spinnerAnim, 100, 20);
+ *
+ *	void loop()
+ *	{
+ *		GLCD.PlayAnimation(spinner);	// draws the next frame when it is due
+ *		...
+ *	}
+ *
+ * The animation data is made by the bitmap tool. It starts with the width, height,
+ * number of frames and the milliseconds from one frame to the next (2 bytes, low byte first).
+ * Then comes frame 0, the changes to each of the frames after it and
+ * the changes from the last frame back to frame 0 so the animation loops.
+ * Each of those is 2 bytes of length (low byte first) followed by that many bytes of
+ * runs as described for DrawBitmapRLE().
+ *
+ * Since the changes are drawn over the frame before, nothing else should be drawn
+ * over the animation while it plays. Restart() draws frame 0 in full again.
+ */
+class glcd_Animation
+{
+  public:
+	glcd_Animation(ImageAnim_t anim, int16_t x, int16_t y, uint8_t color = BLACK);
+	void Restart(void);
+
+	ImageAnim_t	Anim;		// the animation data
+	const uint8_t *Next;	// the frame or changes to draw next
+	int16_t		X;
+	int16_t		Y;
+	uint8_t		Color;
+	uint8_t		Frame;		// number of the next frame, 0 draws frame 0 in full
+	unsigned long Time;		// millis() when the last frame was due
+};
+
 
 /**
  * @class glcd
@@ -61,8 +157,28 @@ typedef const uint8_t* ImageXBM_t; // a "xbm" format bitmap (includes width & he
 class glcd : public gText  
 {
   private:
+	/*
+	 * pixels collected by the drawing functions for a run of adjacent columns on one page
+	 */
+	struct DotSpan {
+		uint8_t masks[GLCD_BLOCKBUF_SIZE];	// pixels for each column
+		uint8_t n;							// number of columns
+		uint8_t x;							// first column
+		uint8_t page;
+		int8_t dir;							// 1 for left to right, -1 for right to left
+	};
+	void SpanDot(DotSpan &span, uint8_t x, uint8_t y, uint8_t color);
+	void SpanFlush(DotSpan &span, uint8_t color);
+	void OutlineColumn(DotSpan *spans, int16_t x, int16_t y1, int16_t y2, int16_t y3, int16_t y4, uint8_t color);
+	void BitmapBand(const uint8_t *data, uint8_t len, uint8_t x, int16_t y, uint8_t mask, uint8_t color,
+		DataCallback rdfunc);
+	void ColumnSpans(int16_t x1, int16_t x2, int16_t y1, int16_t y2, uint8_t color);
+	void SpriteBlit(const uint8_t *data, const uint8_t *mask, DataCallback rdfunc, uint8_t width, uint8_t height,
+		uint8_t bands, uint8_t shift, int16_t x, int16_t y, spriteMode mode);
+	void DrawRuns(const uint8_t *runs, uint8_t width, uint8_t height, int16_t x, int16_t y, uint8_t color);
   public:
 	glcd();
+	glcd(glcd_DeviceState &state);
 	
 /** @name CONTROL FUNCTIONS
  * The following control functions are available
@@ -79,37 +195,61 @@ class glcd : public gText
 /*@{*/
 	// Graphic Functions
 	void ClearScreen(uint8_t color = WHITE);
-	void DrawVLine(uint8_t x, uint8_t y, uint8_t height, uint8_t color= BLACK);
-	void DrawHLine(uint8_t x, uint8_t y, uint8_t width, uint8_t color= BLACK);
-	void DrawLine(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t color= BLACK);
-	void DrawRect(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t color= BLACK);
-	void DrawRoundRect(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t radius, uint8_t color= BLACK);
-	void FillRect(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t color= BLACK);
-	void InvertRect(uint8_t x, uint8_t y, uint8_t width, uint8_t height);
-	void DrawCircle(uint8_t xCenter, uint8_t yCenter, uint8_t radius, uint8_t color= BLACK);	
-	void FillCircle(uint8_t xCenter, uint8_t yCenter, uint8_t radius, uint8_t color= BLACK);	
-	void DrawBitmap(Image_t bitmap, uint8_t x, uint8_t y, uint8_t color= BLACK);
-#ifdef NOTYET
-	void DrawBitmapXBM(ImageXBM_t bitmapxbm, uint8_t x, uint8_t y, uint8_t color= BLACK);
-	void DrawBitmapXBM_P(uint8_t width, uint8_t height, uint8_t *xbmbits, uint8_t x, uint8_t y, 
+	// coordinates are signed so shapes can hang off the edges of the display
+	void DrawVLine(int16_t x, int16_t y, uint8_t height, uint8_t color= BLACK);
+	void DrawHLine(int16_t x, int16_t y, uint8_t width, uint8_t color= BLACK);
+	void DrawLine(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t color= BLACK);
+	void DrawRect(int16_t x, int16_t y, uint8_t width, uint8_t height, uint8_t color= BLACK);
+	void DrawRoundRect(int16_t x, int16_t y, uint8_t width, uint8_t height, uint8_t radius, uint8_t color= BLACK);
+	void FillRect(int16_t x, int16_t y, uint8_t width, uint8_t height, uint8_t color= BLACK);
+	void InvertRect(int16_t x, int16_t y, uint8_t width, uint8_t height);
+	void DrawCircle(int16_t xCenter, int16_t yCenter, uint8_t radius, uint8_t color= BLACK);	
+	void FillCircle(int16_t xCenter, int16_t yCenter, uint8_t radius, uint8_t color= BLACK);	
+	void FillEllipse(int16_t xCenter, int16_t yCenter, uint8_t xRadius, uint8_t yRadius, uint8_t color= BLACK);
+	void DrawBitmap(Image_t bitmap, int16_t x, int16_t y, uint8_t color= BLACK);
+	void DrawBitmapRLE(ImageRLE_t bitmap, int16_t x, int16_t y, uint8_t color= BLACK);
+	uint8_t PlayAnimation(glcd_Animation &anim);
+	void DrawSprite(Image_t sprite, int16_t x, int16_t y, spriteMode mode= SPRITE_OPAQUE, Image_t mask= 0);
+	void DrawSprite(glcd_SpriteCache &sprite, int16_t x, int16_t y, spriteMode mode= SPRITE_OPAQUE);
+	void DrawBitmapXBM(ImageXBM_t bitmapxbm, int16_t x, int16_t y, uint8_t color= BLACK);
+	void DrawBitmapXBM_P(uint8_t width, uint8_t height, const uint8_t *xbmbits, int16_t x, int16_t y, 
 		uint8_t fg_color, uint8_t bg_color);
-#endif
 
 #ifdef DOXYGEN
 	/*
 	 * Define functions to get them to show up properly
 	 * in doxygen
 	 */
-	void SetDot(uint8_t x, uint8_t y, uint8_t color);
-	void SetPixels(uint8_t x, uint8_t y,uint8_t x1, uint8_t y1, uint8_t color);
+	void SetDot(int16_t x, int16_t y, uint8_t color);
+	void SetPixels(int16_t x, int16_t y, int16_t x1, int16_t y1, uint8_t color);
+	uint8_t PushClip(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+	void PopClip(void);
+	void ResetClip(void);
 	uint8_t ReadData(void);        // now public
+	void ReadDataBlock(uint8_t *buf, uint8_t len);
 
     void WriteData(uint8_t data); 
+	void WriteDataBlock(const uint8_t *data, uint8_t len, DataCallback rdfunc = 0, uint8_t color = BLACK);
+
+	void Flush(void);
+	void SetFlushMode(flushMode mode, uint16_t interval = 0);
+	void BeginUpdate(void);
+	void EndUpdate(void);
 #else
 	using glcd_Device::SetDot;
 	using glcd_Device::SetPixels;
+	using glcd_Device::PushClip;
+	using glcd_Device::PopClip;
+	using glcd_Device::ResetClip;
 	using glcd_Device::ReadData; 
+	using glcd_Device::ReadDataBlock;
 	using glcd_Device::WriteData; 
+	using glcd_Device::WriteDataBlock; 
+
+	using glcd_Device::Flush;
+	using glcd_Device::SetFlushMode;
+	using glcd_Device::BeginUpdate;
+	using glcd_Device::EndUpdate;
 #endif
 
 
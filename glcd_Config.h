@@ -112,6 +112,42 @@
 				// This will not work on smaller AVRs like the mega168 that only
 				// have 1k of RAM total.
 
+//#define GLCD_FONT_INDEX 96    // Turns on a RAM index of where each character starts in a
+				// variable width font, so finding a character takes a single lookup
+				// rather than adding up the widths of all the characters before it
+				// (about 70 font reads for a lower case letter in Arial14).
+				// The value is the number of characters indexed (up to 255), 2 bytes of RAM each.
+				// Characters past them are found from the last one indexed.
+				// There is one index shared by all text areas, it is rebuilt when
+				// text areas take turns drawing with different fonts.
+
+//#define GLCD_GLYPH_CACHE 12   // Turns on a RAM cache of the glyph data of the characters drawn most
+				// recently, so drawing them again (say the digits of a readout that
+				// keeps changing) reads nothing but the font height from the font.
+				// Worth it when fonts are read through a slow FontCallback
+				// (external EEPROM or SPI flash).
+				// The value is the number of glyphs kept, the least recently used is
+				// replaced. Each takes GLCD_GLYPH_CACHE_SIZE (default 32) + 7 bytes of RAM
+				// and glyphs with more data than that are not cached.
+				// The glyphs of all fonts and text areas share it. It is emptied when
+				// SelectFont() changes the font callback, so fonts in RAM must not be
+				// changed while their glyphs are cached.
+
+//#define GLCD_FRAMEBUFFER      // Turns on a full frame buffer, all drawing is done in RAM
+				// and the changed areas are sent to the glcd by GLCD.Flush().
+				// Uses the same RAM as GLCD_READ_CACHE (and turns it on).
+				// By default every drawing function flushes when done,
+				// see SetFlushMode() for manual and timed flushing.
+				// Cuts bus traffic a lot for text scrolling, circles, unaligned
+				// text and bitmaps since there are no glcd reads at all.
+
+//#define GLCD_TIMED_IO         // Turns on code that waits out the glcd busy time rather than
+				// polling the busy status before each glcd cycle.
+				// Init() measures how long the attached glcd actually needs and
+				// keeps busy polling if it is slower than GLCD_tBUSY.
+				// Saves the data port direction changes and status reads,
+				// which are expensive with GLCD_BITSHIFT_COMMS.
+
 #define GLCD_BITSHIFT_COMMS
 
 #endif
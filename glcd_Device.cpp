@@ -31,11 +31,9 @@
 
 
 /*
- * define the static variables declared in glcd_Device
+ * state of the default display, used by GLCD
  */
-
-uint8_t	 glcd_Device::Inverted; 
-lcdCoord  glcd_Device::Coord;
+glcd_DeviceState glcd_DefaultDisplay;
 
 /*
  * Experimental defines
@@ -94,9 +92,113 @@ lcdCoord  glcd_Device::Coord;
 
 #ifdef GLCD_READ_CACHE
 /*
- * Declare a static buffer for the Frame buffer for the Read Cache
+ * The Read Cache buffer is in the display state
  */
-uint8_t glcd_rdcache[DISPLAY_HEIGHT/8][DISPLAY_WIDTH];
+#define glcd_rdcache (this->Dev->RdCache)
+#endif
+
+/*
+ * A page row of the display is split into lanes, one per chip
+ * the row goes through. Lane n is columns n*CHIP_WIDTH up to glcd_LaneEnd(n).
+ * Block writes and Flush() send bytes to each lane in turn,
+ * so each chip gets the time taken by the others to finish its busy time.
+ */
+#define glcd_LANES			glcd_Panel::ChipCols
+#define glcd_LaneEnd(lane)	((lane) < glcd_LANES - 1 ? ((lane) + 1) * CHIP_WIDTH : DISPLAY_WIDTH)
+
+#ifdef GLCD_FRAMEBUFFER
+/*
+ * Dirty columns of the frame buffer.
+ * One bit per column for each page, set when the frame buffer byte
+ * is changed and cleared when Flush() sends it to the glcd.
+ */
+#define glcd_dirty (this->Dev->Dirty)
+
+#define glcd_MarkDirty(page, x) (glcd_dirty[page][(x)/8] |= _BV((x)%8))
+
+/*
+ * Number of clean columns that Flush() will rewrite to join two dirty runs
+ * on the same chip rather than start a new run.
+ * Starting a run costs a set column command which takes about the same
+ * bus time as a data write, so gaps up to one column are not worth
+ * re-addressing.
+ */
+#ifndef GLCD_FLUSH_GAP
+#define GLCD_FLUSH_GAP 1
+#endif
+
+/*
+ * return the first dirty column at or after x in the dirty bits of a page
+ * or DISPLAY_WIDTH if there are none.
+ */
+static uint8_t glcd_NextDirty(const uint8_t *dirty, uint8_t x)
+{
+	while(x < DISPLAY_WIDTH)
+	{
+		uint8_t bits = dirty[x/8] >> (x%8);
+
+		if(!bits)
+		{
+			x = (x | 7) + 1;	// nothing left in this byte
+			continue;
+		}
+		while(!(bits & 1))
+		{
+			bits >>= 1;
+			x++;
+		}
+		break;
+	}
+	return(x < DISPLAY_WIDTH ? x : DISPLAY_WIDTH);
+}
+
+/*
+ * find the next run of dirty columns starting at or after x and before end.
+ * Returns the first column of the run (or end if there are none)
+ * and sets *last to the last column of the run.
+ * Runs are joined across clean gaps of up to GLCD_FLUSH_GAP columns.
+ */
+static uint8_t glcd_NextRun(const uint8_t *dirty, uint8_t x, uint8_t end, uint8_t *last)
+{
+	uint8_t next;
+
+	if((x = glcd_NextDirty(dirty, x)) >= end)
+		return(end);
+
+	*last = x;
+	while((next = glcd_NextDirty(dirty, *last+1)) < end && next - *last - 1 <= GLCD_FLUSH_GAP)
+		*last = next;
+	return(x);
+}
+#endif
+
+#ifdef GLCD_TIMED_IO
+/*
+ * Upper limit of the controller busy time after a command or data cycle
+ * in nanoseconds. This is the datasheet worst case, 3/fclk with the typical
+ * 250Khz clock used on ks0108 modules.
+ * The actual wait is calibrated against the glcd in Init(), in steps of GLCD_tBUSYSTEP.
+ * Panel config files can override either of them.
+ */
+#ifndef GLCD_tBUSY
+#define GLCD_tBUSY	12000
+#endif
+#ifndef GLCD_tBUSYSTEP
+#define GLCD_tBUSYSTEP	500
+#endif
+
+static uint8_t glcd_busychips;		// chips that may still be busy (bit per chip), shared by all displays
+
+/*
+ * number of bytes the self test writes and reads back on each chip
+ */
+#define GLCD_TIMEDIO_TESTLEN 8
+
+/*
+ * self test byte i, it changes with each step so that bytes left over
+ * from the previous try can't pass.
+ */
+#define glcd_TestPattern(steps, i) ((uint8_t)((steps) * 0x35 ^ (i) * 0x11))
 #endif
 
 	
@@ -106,26 +208,111 @@ uint8_t glcd_rdcache[DISPLAY_HEIGHT/8][DISPLAY_WIDTH];
 #include <SPI.h>              // We use this library, so it must be called here.
 #include <MCP23S17.h>         // Here is the new class to make using the MCP23S17 easy.
 
-MCP chip23s17one(1);             // Instantiate MCP23S17 device at address 1
+#define GLCD_MCP_ADDR	1		// hardware address of the MCP23S17 (A2..A0 pins)
 
-void lcdDataOut(uint8_t data) {
-  chip23s17one.byteWrite(IODIRA, 0x00);	//0=output
-	chip23s17one.byteWrite(GPIOA,data);
+MCP chip23s17one(GLCD_MCP_ADDR);	// Instantiate MCP23S17 device at address 1
+
+/*
+ * Shadow of the MCP23S17 port A direction register (IODIRA).
+ * 0xff is input, 0x00 is output.
+ * Tracking it here avoids rewriting IODIRA on every data byte,
+ * the register is only touched when the direction actually changes.
+ */
+static uint8_t glcd_mcpIODIR = 0xff;
+
+/*
+ * Start/end an SPI transaction with the MCP23S17 at register reg.
+ * The MCP library only does single register transactions so
+ * the longer bursts are done here directly on the SPI bus.
+ */
+static inline void mcpBegin(uint8_t opcode, uint8_t reg)
+{
+	digitalWrite(SS, LOW);
+	SPI.transfer(opcode | (GLCD_MCP_ADDR << 1));
+	SPI.transfer(reg);
 }
 
-uint8_t lcdDataIn() {
-	//Read from GPIOA
-  chip23s17one.byteWrite(IODIRA, 0xFF);	//FF=input
-  uint8_t data= chip23s17one.byteRead(GPIOA);
-	return data;
+static inline void mcpEnd(void)
+{
+	digitalWrite(SS, HIGH);
 }
 
+/*
+ * Set the data port direction.
+ * Switching to input is done right away since the glcd is about to
+ * drive the bus. Switching to output is deferred to lcdDataOut() so
+ * the direction change goes out in the same SPI burst as the data.
+ */
+void lcdDataDir(uint8_t dirbits)
+{
+	if(!dirbits && glcd_mcpIODIR != 0xff)
+	{
+		chip23s17one.byteWrite(IODIRA, 0xff);	// FF=input
+		glcd_mcpIODIR = 0xff;
+	}
+}
+
+/*
+ * Drive a byte on the data port.
+ * If the port is already an output, this is a single register write.
+ * Otherwise the expander is in sequential address mode (IOCON.SEQOP=0, BANK=0)
+ * so a burst starting at OLATA walks OLATA, OLATB and then wraps to IODIRA.
+ * That sets the data and turns on the outputs in a single transaction.
+ */
+void lcdDataOut(uint8_t data)
+{
+	if(!glcd_mcpIODIR)
+	{
+		chip23s17one.byteWrite(OLATA, data);
+		return;
+	}
+	mcpBegin(OPCODEW, OLATA);
+	SPI.transfer(data);		// OLATA
+	SPI.transfer(0);		// OLATB, port B is not used
+	SPI.transfer(0x00);		// IODIRA, 0=output
+	mcpEnd();
+	glcd_mcpIODIR = 0x00;
+}
+
+uint8_t lcdDataIn()
+{
+	lcdDataDir(0x00);		// normally a nop, WaitReady() already did it
+	return(chip23s17one.byteRead(GPIOA));
+}
 
 #endif
 
 
 glcd_Device::glcd_Device(){
-  
+	this->Dev = &glcd_DefaultDisplay;
+}
+
+glcd_Device::glcd_Device(glcd_DeviceState &state){
+	this->Dev = &state;
+}
+
+glcd_DeviceState::glcd_DeviceState(uint8_t display){
+	memset(&this->Coord, 0, sizeof(this->Coord));
+	this->Inverted = 0;
+	this->Display = display;
+	this->Clip.x1 = this->Clip.y1 = 0;
+	this->Clip.x2 = DISPLAY_WIDTH-1;
+	this->Clip.y2 = DISPLAY_HEIGHT-1;
+	memset(this->ClipStack, 0, sizeof(this->ClipStack));
+	this->ClipDepth = 0;
+#ifdef GLCD_TIMED_IO
+	this->BusySteps = 0;
+#endif
+#ifdef GLCD_FRAMEBUFFER
+	this->UpdateDepth = 0;
+	this->FlushMode = FLUSH_AUTO;
+	this->FlushInterval = 0;
+	this->FlushTime = 0;
+	memset(this->Dirty, 0, sizeof(this->Dirty));
+#endif
+#ifdef GLCD_READ_CACHE
+	memset(this->RdCache, 0, sizeof(this->RdCache));
+#endif
 }
 
 /**
@@ -138,20 +325,22 @@ glcd_Device::glcd_Device(){
  * Sets the pixel at location x,y to the specified color.
  * x and y are relative to the 0,0 origin of the display which
  * is the upper left corner.
- * Requests to set pixels outside the range of the display will be ignored.
+ * Requests to set pixels outside the range of the display
+ * (including negative coordinates) or outside the clip area will be ignored.
  *
  * @note If the display has been set to INVERTED mode then the colors
  * will be automically reversed.
  *
  */
 
-void glcd_Device::SetDot(uint8_t x, uint8_t y, uint8_t color) 
+void glcd_Device::SetDot(int16_t x, int16_t y, uint8_t color) 
 {
 	uint8_t data;
 
-	if((x >= DISPLAY_WIDTH) || (y >= DISPLAY_HEIGHT))
+	if((x < this->Dev->Clip.x1) || (x > this->Dev->Clip.x2) || (y < this->Dev->Clip.y1) || (y > this->Dev->Clip.y2))
 		return;
 	
+	this->BeginUpdate();
 	this->GotoXY(x, y-y%8);					// read data from display memory
   	
 	data = this->ReadData();
@@ -161,6 +350,7 @@ void glcd_Device::SetDot(uint8_t x, uint8_t y, uint8_t color)
 		data &= ~(0x01 << (y%8));			// clear dot
 	}	
 	this->WriteData(data);					// write data back to display
+	this->EndUpdate();
 }
 
 /**
@@ -178,17 +368,27 @@ void glcd_Device::SetDot(uint8_t x, uint8_t y, uint8_t color)
  * The width of the area is x2-x + 1. 
  * The height of the area is y2-y+1 
  * 
+ * Only the part of the area inside the clip area is set,
+ * so the area can hang off any edge of the display.
  *
  */
 
 // set pixels from upper left edge x,y to lower right edge x1,y1 to the given color
 // the width of the region is x1-x + 1, height is y1-y+1 
 
-void glcd_Device::SetPixels(uint8_t x, uint8_t y,uint8_t x2, uint8_t y2, uint8_t color)
+void glcd_Device::SetPixels(int16_t x, int16_t y, int16_t x2, int16_t y2, uint8_t color)
 {
-uint8_t mask, pageOffset, h, i, data;
-uint8_t height = y2-y+1;
-uint8_t width = x2-x+1;
+uint8_t mask, pageOffset, h;
+uint8_t height, width;
+
+	if(x < this->Dev->Clip.x1) x = this->Dev->Clip.x1;
+	if(y < this->Dev->Clip.y1) y = this->Dev->Clip.y1;
+	if(x2 > this->Dev->Clip.x2) x2 = this->Dev->Clip.x2;
+	if(y2 > this->Dev->Clip.y2) y2 = this->Dev->Clip.y2;
+	if(x > x2 || y > y2)
+		return;
+	height = y2-y+1;
+	width = x2-x+1;
 	
 	pageOffset = y%8;
 	y -= pageOffset;
@@ -201,45 +401,114 @@ uint8_t width = x2-x+1;
 	}
 	mask <<= pageOffset;
 	
+	this->BeginUpdate();
 	this->GotoXY(x, y);
-	for(i=0; i < width; i++) {
-		data = this->ReadData();
-		
-		if(color == BLACK) {
-			data |= mask;
-		} else {
-			data &= ~mask;
-		}
-
-		this->WriteData(data);
-	}
+	this->ModifyData(width, ~mask, color & mask);
 	
 	while(h+8 <= height) {
 		h += 8;
 		y += 8;
 		this->GotoXY(x, y);
-		
-		for(i=0; i <width; i++) {
-			this->WriteData(color);
-		}
+		this->DoWriteBlock(&color, width, 0, 0, 0);
 	}
 	
 	if(h < height) {
 		mask = ~(0xFF << (height-h));
 		this->GotoXY(x, y+8);
-		
-		for(i=0; i < width; i++) {
-			data = this->ReadData();
-		
-			if(color == BLACK) {
-				data |= mask;
-			} else {
-				data &= ~mask;
-			}
-	
-			this->WriteData(data);
-		}
+		this->ModifyData(width, ~mask, color & mask);
+	}
+	this->EndUpdate();
+}
+
+/**
+ * limit drawing to an area
+ *
+ * @param x1 X coordinate of upper left corner
+ * @param y1 Y coordinate of upper left corner
+ * @param x2 X coordinate of lower right corner
+ * @param y2 Y coordinate of lower right corner
+ *
+ * @return GLCD_ENOERR, or GLCD_EOVERFLOW if GLCD_CLIP_DEPTH areas
+ * have already been pushed, in which case nothing changes.
+ *
+ * Saves the current clip area and replaces it with the part of it
+ * that is inside x1,y1 to x2,y2 inclusive, so nested areas can only
+ * make it smaller. The area can extend past the edges of the display,
+ * only the part on the display is used. If none of it is on the display
+ * the clip area is empty and nothing is drawn until PopClip().
+ * The pixels outside of the clip area are not touched
+ * by the drawing functions, and the drawing functions skip the parts
+ * of what they draw that are outside of it without working them out.
+ * This lets a widget draw into a viewport on the display without
+ * having to care about its edges.
+ *
+ * The clip area belongs to the display so it applies to all the
+ * objects drawing on it, including text areas.
+ * Init() resets the clip area to the entire display.
+ *
+ * @note Raw data functions such as WriteData() and the scrolling of a text area
+ * are not clipped.
+ *
+ * @see PopClip()
+ * @see ResetClip()
+ */
+
+uint8_t glcd_Device::PushClip(int16_t x1, int16_t y1, int16_t x2, int16_t y2)
+{
+	lcdClip *clip = &this->Dev->Clip;
+
+	if(this->Dev->ClipDepth >= GLCD_CLIP_DEPTH)
+		return(GLCD_EOVERFLOW);
+	this->Dev->ClipStack[this->Dev->ClipDepth++] = *clip;
+
+	/*
+	 * Clamp to the display while the coordinates are still signed,
+	 * the clip area only holds on screen coordinates.
+	 */
+	if(x1 < 0) x1 = 0;
+	if(y1 < 0) y1 = 0;
+	if(x2 > DISPLAY_WIDTH-1) x2 = DISPLAY_WIDTH-1;
+	if(y2 > DISPLAY_HEIGHT-1) y2 = DISPLAY_HEIGHT-1;
+	if(x1 > x2 || y1 > y2)
+	{
+		clip->x1 = clip->y1 = 1;	// empty, x1 > x2 and y1 > y2
+		clip->x2 = clip->y2 = 0;
+		return(GLCD_ENOERR);
 	}
+
+	if(x1 > clip->x1) clip->x1 = x1;
+	if(y1 > clip->y1) clip->y1 = y1;
+	if(x2 < clip->x2) clip->x2 = x2;
+	if(y2 < clip->y2) clip->y2 = y2;
+	return(GLCD_ENOERR);
+}
+
+/**
+ * restore the clip area saved by the last PushClip()
+ *
+ * Does nothing if there is nothing left to restore.
+ *
+ * @see PushClip()
+ */
+
+void glcd_Device::PopClip(void)
+{
+	if(this->Dev->ClipDepth)
+		this->Dev->Clip = this->Dev->ClipStack[--this->Dev->ClipDepth];
+}
+
+/**
+ * make the entire display the clip area and discard any saved clip areas
+ *
+ * @see PushClip()
+ */
+
+void glcd_Device::ResetClip(void)
+{
+	this->Dev->Clip.x1 = this->Dev->Clip.y1 = 0;
+	this->Dev->Clip.x2 = DISPLAY_WIDTH-1;
+	this->Dev->Clip.y2 = DISPLAY_HEIGHT-1;
+	this->Dev->ClipDepth = 0;
 }
 
 /**
@@ -255,9 +524,7 @@ uint8_t width = x2-x+1;
 
 void glcd_Device::GotoXY(uint8_t x, uint8_t y)
 {
-  uint8_t chip, cmd;
-
-  if((x == this->Coord.x) && (y == this->Coord.y))
+  if((x == this->Dev->Coord.x) && (y == this->Dev->Coord.y))
 	return;
 
   if( (x > DISPLAY_WIDTH-1) || (y > DISPLAY_HEIGHT-1) )	// exit if coordinates are not legal  
@@ -265,15 +532,28 @@ void glcd_Device::GotoXY(uint8_t x, uint8_t y)
     return;
   }
 
-  this->Coord.x = x;								// save new coordinates
-  this->Coord.y = y;
+  this->Dev->Coord.x = x;								// save new coordinates
+  this->Dev->Coord.y = y;
+
+#ifndef GLCD_FRAMEBUFFER
+  this->DoGotoXY(x, y);		// with a frame buffer the h/w is only positioned by Flush()
+#endif
+}
+
+/*
+ * set the glcd hardware page and column address for x,y
+ * The s/w coordinates in Coord.x and Coord.y are not modified.
+ */
+void glcd_Device::DoGotoXY(uint8_t x, uint8_t y)
+{
+  uint8_t chip, cmd;
 
   chip = glcd_DevXYval2Chip(x, y);
 
-	if(y/8 != this->Coord.chip[chip].page)
+	if(y/8 != this->Dev->Coord.chip[chip].page)
 	{
-  		this->Coord.chip[chip].page = y/8;
-		cmd = LCD_SET_PAGE | this->Coord.chip[chip].page;
+  		this->Dev->Coord.chip[chip].page = y/8;
+		cmd = LCD_SET_PAGE | this->Dev->Coord.chip[chip].page;
 	   	this->WriteCommand(cmd, chip);	
 	}
 	
@@ -288,12 +568,12 @@ void glcd_Device::GotoXY(uint8_t x, uint8_t y)
 	x = glcd_DevXval2ChipCol(x);
 
 #ifdef GLCD_XCOL_SUPPORT
-	if(x != this->Coord.chip[chip].col)
+	if(x != this->Dev->Coord.chip[chip].col)
 #endif
 	{
 
 #ifdef GLCD_XCOL_SUPPORT
-		this->Coord.chip[chip].col = x;
+		this->Dev->Coord.chip[chip].col = x;
 #endif
 
 #ifdef LCD_SET_ADDLO
@@ -338,15 +618,21 @@ void glcd_Device::GotoXY(uint8_t x, uint8_t y)
 int glcd_Device::Init(uint8_t invert)
 {  
 
+#ifdef GLCD_TIMED_IO
+	this->Dev->BusySteps = 0;		// init commands always poll
+#endif
+
 	/*
 	 * Now setup the pinmode for all of our control pins.
 	 * The data lines will be configured as necessary when needed.
 	 */
 
 #ifdef GLCD_BITSHIFT_COMMS
-  chip23s17one.byteWrite(IODIRA, 0xFF);
-  chip23s17one.byteWrite(IPOLA, 0); 
-  chip23s17one.byteWrite(GPPUA, 0xFF);
+	chip23s17one.byteWrite(IOCON, ADDR_ENABLE);	// BANK=0, sequential mode, used by lcdDataOut()
+	chip23s17one.byteWrite(IODIRA, 0xFF);
+	chip23s17one.byteWrite(IPOLA, 0); 
+	chip23s17one.byteWrite(GPPUA, 0xFF);
+	glcd_mcpIODIR = 0xff;
 #endif
 
 #ifdef glcdDI
@@ -401,10 +687,11 @@ int glcd_Device::Init(uint8_t invert)
 
 	setDI_RW(LOW,LOW);
 
-	this->Coord.x = -1;  // invalidate the s/w coordinates so the first GotoXY() works
-	this->Coord.y = -1;  // invalidate the s/w coordinates so the first GotoXY() works
+	this->Dev->Coord.x = -1;  // invalidate the s/w coordinates so the first GotoXY() works
+	this->Dev->Coord.y = -1;  // invalidate the s/w coordinates so the first GotoXY() works
 	
-	this->Inverted = invert;
+	this->Dev->Inverted = invert;
+	this->ResetClip();
 
 #ifdef glcdRES
 	/*
@@ -456,9 +743,9 @@ int glcd_Device::Init(uint8_t invert)
 		/*
 		 * flush out internal state to force first GotoXY() to talk to GLCD hardware
 		 */
-		this->Coord.chip[chip].page = -1;
+		this->Dev->Coord.chip[chip].page = -1;
 #ifdef GLCD_XCOL_SUPPORT
-		this->Coord.chip[chip].col = -1;
+		this->Dev->Coord.chip[chip].col = -1;
 #endif
 
 #ifdef glcd_DeviceInit // this provides custom chip specific init 
@@ -473,6 +760,10 @@ int glcd_Device::Init(uint8_t invert)
 
 	}
 
+#ifdef GLCD_TIMED_IO
+	this->TimedSelfTest();
+#endif
+
 	/*
 	 * All hardware initialization is complete.
 	 *
@@ -486,12 +777,86 @@ int glcd_Device::Init(uint8_t invert)
 	 * as is required.
 	 */
 
+#ifdef GLCD_FRAMEBUFFER
+	this->Dev->UpdateDepth = 1;	// hold off any auto flush, the entire buffer is flushed below
+#endif
 	this->SetPixels(0,0, DISPLAY_WIDTH-1,DISPLAY_HEIGHT-1, WHITE);
 	this->GotoXY(0,0);
 
+#ifdef GLCD_FRAMEBUFFER
+	/*
+	 * glcd memory contents are unknown after a reset so push the entire frame buffer
+	 * not just what SetPixels() changed.
+	 */
+	memset(glcd_dirty, 0xff, sizeof(glcd_dirty));
+	this->Dev->UpdateDepth = 0;
+	this->Flush();
+#endif
+
 	return(GLCD_ENOERR);
 }
 
+#ifdef GLCD_TIMED_IO
+/*
+ * Find out how long the glcd needs to be left alone after each cycle.
+ *
+ * A pattern is written to the first columns of each chip using
+ * a fixed wait instead of busy polling and then read back with busy polling.
+ * If any byte was dropped because the chip was still busy, the wait
+ * is increased one GLCD_tBUSYSTEP and the test is repeated.
+ *
+ * Once a wait works on all chips, all further i/o uses twice that wait
+ * (to leave margin for temperature and supply changes) instead of polling.
+ * If the glcd needs more than GLCD_tBUSY, busy polling stays on.
+ *
+ * The test columns are overwritten by the screen clear in Init().
+ */
+void glcd_Device::TimedSelfTest(void)
+{
+	uint8_t steps, x, chip, i;
+
+	for(steps = 1; steps <= GLCD_tBUSY/GLCD_tBUSYSTEP/2; steps++)
+	{
+		for(x = 0; x < DISPLAY_WIDTH; x += CHIP_WIDTH)
+		{
+			chip = glcd_DevXYval2Chip(x, 0);
+
+			this->DoGotoXY(x, 0);
+			this->Dev->BusySteps = steps;
+			glcd_busychips = 0;
+			for(i = 0; i < GLCD_TIMEDIO_TESTLEN; i++)
+				this->DoWriteData(glcd_TestPattern(steps, i), chip);
+			this->Dev->BusySteps = 0;
+
+			/*
+			 * position the glcd, dummy read, then read it back
+			 */
+			this->Dev->Coord.chip[chip].page = -1;
+#ifdef GLCD_XCOL_SUPPORT
+			this->Dev->Coord.chip[chip].col = -1;
+#endif
+			this->Dev->Coord.x = x;
+			this->Dev->Coord.y = 0;
+			this->DoGotoXY(x, 0);
+			this->DoReadData();
+			for(i = 0; i < GLCD_TIMEDIO_TESTLEN; i++)
+			{
+				if(this->DoReadData() != glcd_TestPattern(steps, i))
+					break;
+			}
+			if(i < GLCD_TIMEDIO_TESTLEN)
+				break;
+		}
+		if(x >= DISPLAY_WIDTH)
+		{
+			this->Dev->BusySteps = steps * 2;
+			glcd_busychips = _BV(glcd_CHIP_COUNT) - 1;
+			return;
+		}
+	}
+}
+#endif
+
 #ifdef glcd_CHIP0  // if at least one chip select string
 __inline__ void glcd_Device::SelectChip(uint8_t chip)
 {  
@@ -514,13 +879,12 @@ uint8_t glcd_Device::GetStatus(uint8_t chip)
 {
 	uint8_t status;
 
+#ifdef glcd_DevSelectDisplay
+	glcd_DevSelectDisplay(this->Dev->Display);
+#endif
 	glcd_DevSelectChip(chip);
 	lcdDataDir(0x00);			// input mode
 
-#ifdef GLCD_BITSHIFT_COMMS
-	lcdDataOut(0xff);			// turn on pullups
-#endif
-
 	setDI_RW(LOW,HIGH);
 	//lcdfastWrite(glcdDI, LOW);	
 	//lcdfastWrite(glcdRW, HIGH);	
@@ -539,7 +903,27 @@ uint8_t glcd_Device::GetStatus(uint8_t chip)
 // wait until LCD busy bit goes to zero
 void glcd_Device::WaitReady( uint8_t chip)
 {
+#ifdef glcd_DevSelectDisplay
+	glcd_DevSelectDisplay(this->Dev->Display);
+#endif
 	glcd_DevSelectChip(chip);
+#ifdef GLCD_TIMED_IO
+	if(this->Dev->BusySteps)
+	{
+		/*
+		 * Open loop, just wait out the busy time of the last cycle sent to this chip.
+		 * Cycles sent to the other chips happened before that one, so they are done too.
+		 */
+		if(glcd_busychips & _BV(chip))
+		{
+			for(uint8_t i = this->Dev->BusySteps; i; i--)
+				lcdDelayNanoseconds(GLCD_tBUSYSTEP);
+			glcd_busychips = 0;
+		}
+		glcd_busychips |= _BV(chip);	// caller is about to start a cycle
+		return;
+	}
+#endif
 	lcdDataDir(0x00);
 	setDI_RW(LOW,HIGH);
 	glcd_DevENstrobeHi(chip);
@@ -553,7 +937,7 @@ void glcd_Device::WaitReady( uint8_t chip)
 }
 
 
-#ifndef GLCD_BITSHIFT_COMMS
+#ifdef GLCD_TIMED_IO
 
 /*
  * read a single data byte from chip
@@ -562,10 +946,11 @@ uint8_t glcd_Device::DoReadData()
 {
 	uint8_t data, chip;
 
-	chip = glcd_DevXYval2Chip(this->Coord.x, this->Coord.y);
+	chip = glcd_DevXYval2Chip(this->Dev->Coord.x, this->Dev->Coord.y);
 	this->WaitReady(chip);
 
 	setDI_RW(HIGH,HIGH);
+	lcdDataDir(0x00);			// input mode
 	
 	lcdDelayNanoseconds(GLCD_tAS);
 	glcd_DevENstrobeHi(chip);
@@ -575,7 +960,7 @@ uint8_t glcd_Device::DoReadData()
 
 	glcd_DevENstrobeLo(chip);
 #ifdef GLCD_XCOL_SUPPORT
-	this->Coord.chip[chip].col++;
+	this->Dev->Coord.chip[chip].col++;
 #endif
 	return data;
 }
@@ -600,14 +985,14 @@ uint8_t glcd_Device::ReadData()
 {
 	uint8_t x, data;
 
-	x = this->Coord.x;
+	x = this->Dev->Coord.x;
 	if(x >= DISPLAY_WIDTH)
 	{
 		return(0);
 	}
-	data = glcd_rdcache[this->Coord.y/8][x];
+	data = glcd_rdcache[this->Dev->Coord.y/8][x];
 
-	if(this->Inverted)
+	if(this->Dev->Inverted)
 	{
 		data = ~data;
 	}
@@ -615,11 +1000,11 @@ uint8_t glcd_Device::ReadData()
 }
 #else
 
-inline uint8_t glcd_Device::ReadData()
+uint8_t glcd_Device::ReadData()
 {  
 	uint8_t x, data;
 
-	x = this->Coord.x;
+	x = this->Dev->Coord.x;
 	if(x >= DISPLAY_WIDTH)
 	{
 		return(0);
@@ -627,23 +1012,22 @@ inline uint8_t glcd_Device::ReadData()
 
 	uint8_t chip;
 
-	chip = glcd_DevXYval2Chip(this->Coord.x, this->Coord.y);
+	chip = glcd_DevXYval2Chip(this->Dev->Coord.x, this->Dev->Coord.y);
 	this->WaitReady(chip);
 
 	setDI_RW(HIGH,HIGH);
+	lcdDataDir(0x00);			// input mode
 	
 	lcdDelayNanoseconds(GLCD_tAS);
 	glcd_DevENstrobeHi(chip);
 	lcdDelayNanoseconds(GLCD_tDDR);
 
-    chip23s17one.byteWrite(IODIRA, 0xFF);	//FF=input
-
   //	data = lcdDataIn();	// Read the data bits from the LCD
 
 	glcd_DevENstrobeLo(chip);
 
 #ifdef GLCD_XCOL_SUPPORT
-	this->Coord.chip[chip].col++;
+	this->Dev->Coord.chip[chip].col++;
 #endif
 
 	//lcdDelayNanoseconds(GLCD_tAS);
@@ -654,25 +1038,165 @@ inline uint8_t glcd_Device::ReadData()
 
 	glcd_DevENstrobeLo(chip);
 #ifdef GLCD_XCOL_SUPPORT
-	this->Coord.chip[chip].col++;
+	this->Dev->Coord.chip[chip].col++;
 #endif
 
-	if(this->Inverted)
+	if(this->Dev->Inverted)
 	{
 		data = ~data;
 	}
 
-	this->Coord.x = -1;	// force a set column on GotoXY
+	this->Dev->Coord.x = -1;	// force a set column on GotoXY
 
-	this->GotoXY(x, this->Coord.y);	
+	this->GotoXY(x, this->Dev->Coord.y);	
 	return(data);
 }
 #endif
 
+/**
+ * read a block of data bytes from display device memory
+ *
+ * @param buf where to put the data
+ * @param len number of bytes to read
+ *
+ * Reads the bytes of len sequential columns starting at the current x,y position,
+ * the same bytes that calling ReadData() for each column would return.
+ * Columns beyond the right edge of the display read as 0.
+ *
+ * Like ReadData(), the current x,y location is not modified, so the bytes can be
+ * modified and written back with WriteDataBlock().
+ *
+ * On the glcd this needs only one dummy read per chip the block spans
+ * and a single re-positioning at the end, rather than a dummy read and
+ * re-positioning for every byte.
+ *
+ * @see ReadData()
+ * @see WriteDataBlock()
+ */
+
+void glcd_Device::ReadDataBlock(uint8_t *buf, uint8_t len)
+{
+	uint8_t x = this->Dev->Coord.x;
+	uint8_t y = this->Dev->Coord.y;
+
+#ifdef GLCD_READ_CACHE
+	while(len--)
+	{
+		*buf++ = x < DISPLAY_WIDTH ? (this->Dev->Inverted ? ~glcd_rdcache[y/8][x] : glcd_rdcache[y/8][x]) : 0;
+		x++;
+	}
+#else
+	uint8_t cx = x;
+
+	while(len)
+	{
+		if(cx >= DISPLAY_WIDTH)
+		{
+			*buf++ = 0;
+			len--;
+			continue;
+		}
+
+		uint8_t chip = glcd_DevXYval2Chip(cx, y);
+
+		if(cx != x)
+		{
+			this->Dev->Coord.x = -1;		// crossed into the next chip, position the h/w there
+			this->GotoXY(cx, y);
+		}
+
+		this->WaitReady(chip);
+		setDI_RW(HIGH,HIGH);
+		lcdDataDir(0x00);			// input mode
+		lcdDelayNanoseconds(GLCD_tAS);
+
+		/*
+		 * dummy read to get the data for the column into the output latch
+		 */
+		glcd_DevENstrobeHi(chip);
+		lcdDelayNanoseconds(GLCD_tDDR);
+		glcd_DevENstrobeLo(chip);
+
+		do
+		{
+			uint8_t data;
+
+			lcdDelayNanoseconds(GLCD_tWL);
+			glcd_DevENstrobeHi(chip);
+			lcdDelayNanoseconds(GLCD_tDDR);
+			data = lcdDataIn();
+			glcd_DevENstrobeLo(chip);
+
+			if(this->Dev->Inverted)
+				data = ~data;
+			*buf++ = data;
+			cx++;
+		} while(--len && cx < DISPLAY_WIDTH && glcd_DevXYval2Chip(cx, y) == chip);
+#ifdef GLCD_XCOL_SUPPORT
+		this->Dev->Coord.chip[chip].col = -1;	// read side effects on the column are not tracked
+#endif
+	}
+
+	this->Dev->Coord.x = -1;	// force a set column on GotoXY
+	this->GotoXY(x, y);
+#endif
+}
+
+/*
+ * read-modify-write len bytes starting at the current x,y position.
+ * Each byte becomes (byte & andmask) ^ xormask, the x position ends
+ * up just past the last byte.
+ * y must be on a page boundary.
+ */
+void glcd_Device::ModifyData(uint8_t len, uint8_t andmask, uint8_t xormask)
+{
+	uint8_t buf[GLCD_BLOCKBUF_SIZE];
+
+	while(len)
+	{
+		uint8_t n = len < sizeof(buf) ? len : sizeof(buf);
+
+		this->ReadDataBlock(buf, n);
+		for(uint8_t i = 0; i < n; i++)
+			buf[i] = (buf[i] & andmask) ^ xormask;
+		this->WriteDataBlock(buf, n);
+		len -= n;
+	}
+}
+
+/*
+ * set (color BLACK) or clear (any other color) the pixels given by
+ * a bit mask for each of len columns starting at the current x,y position.
+ * Each column is read and written once no matter how many bits are set in
+ * its mask, the x position ends up just past the last column.
+ * y must be on a page boundary.
+ */
+void glcd_Device::SetPixelMasks(const uint8_t *masks, uint8_t len, uint8_t color)
+{
+	uint8_t buf[GLCD_BLOCKBUF_SIZE];
+
+	while(len)
+	{
+		uint8_t n = len < sizeof(buf) ? len : sizeof(buf);
+
+		this->ReadDataBlock(buf, n);
+		for(uint8_t i = 0; i < n; i++)
+		{
+			if(color == BLACK)
+				buf[i] |= masks[i];
+			else
+				buf[i] &= ~masks[i];
+		}
+		this->WriteDataBlock(buf, n);
+		masks += n;
+		len -= n;
+	}
+}
+
 void glcd_Device::WriteCommand(uint8_t cmd, uint8_t chip)
 {
 	this->WaitReady(chip);
-	setDI_RW(LOW,LOW)
+	setDI_RW(LOW,LOW);
 	lcdDataDir(0xFF);
 
 	lcdDataOut(cmd);		/* This could be done before or after raising E */
@@ -712,29 +1236,243 @@ void glcd_Device::WriteCommand(uint8_t cmd, uint8_t chip)
  *
  */
 
+/*
+ * write a data byte to the glcd hardware at its current address.
+ * The byte is written as is, nothing but the chip column is tracked.
+ */
+void glcd_Device::DoWriteData(uint8_t data, uint8_t chip)
+{
+	this->WaitReady(chip);
+	setDI_RW(HIGH,LOW);
+	lcdDataDir(0xFF);						// data port is output
+	lcdDelayNanoseconds(GLCD_tAS);
+	glcd_DevENstrobeHi(chip);
+	lcdDataOut(data);
+	lcdDelayNanoseconds(GLCD_tWH);
+	glcd_DevENstrobeLo(chip);
+#ifdef GLCD_XCOL_SUPPORT
+	this->Dev->Coord.chip[chip].col++;
+#endif
+}
+
+#ifdef GLCD_FRAMEBUFFER
+/*
+ * Frame buffer version of WriteData().
+ * The data goes to the frame buffer only and columns whose contents
+ * actually change are marked dirty.
+ * The glcd is updated later by Flush().
+ * Semantics are the same as the direct version, including TRUE_WRITE handling
+ * of writes that span pages.
+ */
+void glcd_Device::WriteData(uint8_t data) {
+	uint8_t displayData, yOffset, x, page;
+
+	x = this->Dev->Coord.x;
+	if(x >= DISPLAY_WIDTH){
+		return;
+	}
+
+	this->BeginUpdate();
+	page = this->Dev->Coord.y/8;
+	yOffset = this->Dev->Coord.y%8;
+
+	if(yOffset != 0) {
+		// first page
+		displayData = this->ReadData();
+#ifdef TRUE_WRITE
+		displayData &= (_BV(yOffset)-1);
+#endif
+		displayData |= data << yOffset;
+		if(this->Dev->Inverted){
+			displayData = ~displayData;
+		}
+		if(glcd_rdcache[page][x] != displayData)
+		{
+			glcd_rdcache[page][x] = displayData;
+			glcd_MarkDirty(page, x);
+		}
+
+		// second page, unless it falls off the bottom of the display
+		if(++page < DISPLAY_HEIGHT/8)
+		{
+			displayData = glcd_rdcache[page][x];
+			if(this->Dev->Inverted){
+				displayData = ~displayData;
+			}
+#ifdef TRUE_WRITE
+			displayData &= ~(_BV(yOffset)-1);
+#endif
+			displayData |= data >> (8-yOffset);
+			if(this->Dev->Inverted){
+				displayData = ~displayData;
+			}
+			if(glcd_rdcache[page][x] != displayData)
+			{
+				glcd_rdcache[page][x] = displayData;
+				glcd_MarkDirty(page, x);
+			}
+		}
+	}else 
+	{
+		if(this->Dev->Inverted)
+			data = ~data;	  
+		if(glcd_rdcache[page][x] != data)
+		{
+			glcd_rdcache[page][x] = data;
+			glcd_MarkDirty(page, x);
+		}
+	}
+
+	/*
+	 * Like the direct version this can bump x beyond the end of the display,
+	 * further writes are ignored until the next GotoXY().
+	 */
+	this->Dev->Coord.x++;
+	this->EndUpdate();
+}
+
+/**
+ * Update the display from the frame buffer
+ *
+ * Sends the frame buffer bytes that have changed since the last flush
+ * to the glcd.
+ *
+ * The dirty columns of each page are sent as runs, each one a positioning
+ * followed by sequential data writes. Runs are joined across short clean
+ * gaps, but never across a chip boundary since the next chip needs its own
+ * positioning anyway. The page and column of each chip are tracked so that
+ * positioning only sends the commands that actually change something.
+ * The runs of the chips a page goes through are sent interleaved, a byte
+ * to each chip in turn, so a chip is rarely still busy when it is next used.
+ *
+ * When the flush mode is FLUSH_AUTO this happens automatically at the
+ * end of each drawing function.
+ *
+ * @note Only available when GLCD_FRAMEBUFFER is enabled
+ * otherwise it does nothing.
+ *
+ * @see SetFlushMode()
+ * @see BeginUpdate()
+ */
+void glcd_Device::Flush(void)
+{
+	uint8_t lx[glcd_LANES], lend[glcd_LANES], lchip[glcd_LANES];
+
+	for(uint8_t page = 0; page < DISPLAY_HEIGHT/8; page++)
+	{
+		const uint8_t *dirty = glcd_dirty[page];
+		uint8_t lane, active = 0;
+
+		/*
+		 * position each chip at its first run
+		 */
+		for(lane = 0; lane < glcd_LANES; lane++)
+		{
+			lchip[lane] = glcd_DevXYval2Chip(lane * CHIP_WIDTH, page*8);
+			lx[lane] = glcd_NextRun(dirty, lane * CHIP_WIDTH, glcd_LaneEnd(lane), &lend[lane]);
+			if(lx[lane] < glcd_LaneEnd(lane))
+			{
+				this->DoGotoXY(lx[lane], page*8);
+				active |= _BV(lane);
+			}
+		}
+
+		/*
+		 * then send the runs a byte per chip in turn
+		 */
+		while(active)
+		{
+			for(lane = 0; lane < glcd_LANES; lane++)
+			{
+				if(!(active & _BV(lane)))
+					continue;
+
+				this->DoWriteData(glcd_rdcache[page][lx[lane]], lchip[lane]);
+				if(lx[lane]++ == lend[lane])
+				{
+					lx[lane] = glcd_NextRun(dirty, lx[lane], glcd_LaneEnd(lane), &lend[lane]);
+					if(lx[lane] < glcd_LaneEnd(lane))
+						this->DoGotoXY(lx[lane], page*8);
+					else
+						active &= ~_BV(lane);
+				}
+			}
+		}
+		memset(glcd_dirty[page], 0, sizeof(glcd_dirty[page]));
+	}
+	this->Dev->FlushTime = millis();
+}
+
+/**
+ * Set the frame buffer flush policy
+ *
+ * @param mode FLUSH_MANUAL, FLUSH_AUTO or FLUSH_TIMED
+ * @param interval minimum milliseconds between flushes for FLUSH_TIMED
+ *
+ * FLUSH_AUTO (the default) flushes at the end of every drawing function
+ * so the display always shows what has been drawn.\n
+ * FLUSH_MANUAL leaves the display alone until Flush() is called.\n
+ * FLUSH_TIMED flushes at the end of a drawing function only when at least
+ * @em interval milliseconds have passed since the previous flush. Drawing done
+ * after the last such flush stays in the frame buffer until the next drawing
+ * function or Flush() call.
+ *
+ * Changing the mode does not flush, call Flush() if needed.
+ *
+ * @see Flush()
+ */
+void glcd_Device::SetFlushMode(flushMode mode, uint16_t interval)
+{
+	this->Dev->FlushMode = mode;
+	this->Dev->FlushInterval = interval;
+}
+
+/**
+ * Mark the end of a group of drawing operations
+ *
+ * BeginUpdate() and EndUpdate() calls nest. All the library drawing functions
+ * use them internally, so with FLUSH_AUTO the display is flushed once per
+ * drawing function rather than once per byte.
+ * A sketch can also wrap a whole frame with them to have it flushed in one go.
+ *
+ * @see BeginUpdate()
+ * @see SetFlushMode()
+ */
+void glcd_Device::EndUpdate(void)
+{
+	if(this->Dev->UpdateDepth && --this->Dev->UpdateDepth)
+		return;
+
+	if(this->Dev->FlushMode == FLUSH_AUTO)
+		this->Flush();
+	else if(this->Dev->FlushMode == FLUSH_TIMED && millis() - this->Dev->FlushTime >= this->Dev->FlushInterval)
+		this->Flush();
+}
+#else
+
 void glcd_Device::WriteData(uint8_t data) {
 	uint8_t displayData, yOffset, chip;
 	//showHex("wrData",data);
-    //showXY("wr", this->Coord.x,this->Coord.y);
+    //showXY("wr", this->Dev->Coord.x,this->Dev->Coord.y);
 
 #ifdef GLCD_DEBUG
 	volatile uint16_t i;
 	for(i=0; i<5000; i++);
 #endif
 
-	if(this->Coord.x >= DISPLAY_WIDTH){
+	if(this->Dev->Coord.x >= DISPLAY_WIDTH){
 		return;
 	}
 
-    chip = glcd_DevXYval2Chip(this->Coord.x, this->Coord.y);
+    chip = glcd_DevXYval2Chip(this->Dev->Coord.x, this->Dev->Coord.y);
 	
-	yOffset = this->Coord.y%8;
+	yOffset = this->Dev->Coord.y%8;
 
 	if(yOffset != 0) {
 		// first page
 		displayData = this->ReadData();
 		this->WaitReady(chip);
-		setDI_RW(HIGH,LOW)
+		setDI_RW(HIGH,LOW);
 
 		lcdDataDir(0xFF);						// data port is output
 		lcdDelayNanoseconds(GLCD_tAS);
@@ -749,7 +1487,7 @@ void glcd_Device::WriteData(uint8_t data) {
 
 		displayData |= data << yOffset;
 
-		if(this->Inverted){
+		if(this->Dev->Inverted){
 			displayData = ~displayData;
 		}
 		lcdDataOut( displayData);					// write data
@@ -760,7 +1498,7 @@ void glcd_Device::WriteData(uint8_t data) {
 
 		glcd_DevENstrobeLo(chip);
 #ifdef GLCD_READ_CACHE
-		glcd_rdcache[this->Coord.y/8][this->Coord.x] = displayData; // save to read cache
+		glcd_rdcache[this->Dev->Coord.y/8][this->Dev->Coord.x] = displayData; // save to read cache
 #endif
 
 		// second page
@@ -769,14 +1507,14 @@ void glcd_Device::WriteData(uint8_t data) {
 		 * Make sure to goto y address of start of next page
 		 * and ensure that we don't fall off the bottom of the display.
 		 */
-		uint8_t ysave = this->Coord.y;
+		uint8_t ysave = this->Dev->Coord.y;
 		if(((ysave+8) & ~7) >= DISPLAY_HEIGHT)
 		{
-			this->GotoXY(this->Coord.x+1, ysave);
+			this->GotoXY(this->Dev->Coord.x+1, ysave);
 			return;
 		}
 	
-		this->GotoXY(this->Coord.x, ((ysave+8) & ~7));
+		this->GotoXY(this->Dev->Coord.x, ((ysave+8) & ~7));
 
 		displayData = this->ReadData();
 		this->WaitReady(chip);
@@ -795,16 +1533,16 @@ void glcd_Device::WriteData(uint8_t data) {
 #endif
 
 		displayData |= data >> (8-yOffset);
-		if(this->Inverted){
+		if(this->Dev->Inverted){
 			displayData = ~displayData;
 		}
 		lcdDataOut(displayData);		// write data
 		lcdDelayNanoseconds(GLCD_tWH);
 		glcd_DevENstrobeLo(chip);
 #ifdef GLCD_READ_CACHE
-		glcd_rdcache[this->Coord.y/8][this->Coord.x] = displayData; // save to read cache
+		glcd_rdcache[this->Dev->Coord.y/8][this->Dev->Coord.x] = displayData; // save to read cache
 #endif
-		this->GotoXY(this->Coord.x+1, ysave);
+		this->GotoXY(this->Dev->Coord.x+1, ysave);
 	}else 
 	{
     	this->WaitReady(chip);
@@ -814,7 +1552,7 @@ void glcd_Device::WriteData(uint8_t data) {
 		lcdDataDir(0xFF);						// data port is output
 
 		// just this code gets executed if the write is on a single page
-		if(this->Inverted)
+		if(this->Dev->Inverted)
 			data = ~data;	  
 
 		lcdDelayNanoseconds(GLCD_tAS);
@@ -827,7 +1565,7 @@ void glcd_Device::WriteData(uint8_t data) {
 		glcd_DevENstrobeLo(chip);
 
 #ifdef GLCD_READ_CACHE
-		glcd_rdcache[this->Coord.y/8][this->Coord.x] = data; // save to read cache
+		glcd_rdcache[this->Dev->Coord.y/8][this->Dev->Coord.x] = data; // save to read cache
 #endif
 
 		/*
@@ -849,27 +1587,159 @@ void glcd_Device::WriteData(uint8_t data) {
 		 * both a set column and set page address to reposition the glcd hardware.
 		 */
 
-		this->Coord.x++;
+		this->Dev->Coord.x++;
 #ifdef GLCD_XCOL_SUPPORT
-		this->Coord.chip[chip].col++;
+		this->Dev->Coord.chip[chip].col++;
 #endif
 
 
 		/*
 		 * Check for crossing into the next chip.
 		 */
-		if( glcd_DevXYval2Chip(this->Coord.x, this->Coord.y) != chip)
+		if( glcd_DevXYval2Chip(this->Dev->Coord.x, this->Dev->Coord.y) != chip)
 		{
-			if(this->Coord.x < DISPLAY_WIDTH)
+			if(this->Dev->Coord.x < DISPLAY_WIDTH)
 			{
-				uint8_t x = this->Coord.x;
-				this->Coord.x = -1;
-				this->GotoXY(x, this->Coord.y);
+				uint8_t x = this->Dev->Coord.x;
+				this->Dev->Coord.x = -1;
+				this->GotoXY(x, this->Dev->Coord.y);
 			}
  		}
-	    //showXY("WrData",this->Coord.x, this->Coord.y); 
+	    //showXY("WrData",this->Dev->Coord.x, this->Dev->Coord.y); 
 	}
 }
+#endif // GLCD_FRAMEBUFFER
+
+/**
+ * Write a block of bytes to display device memory
+ *
+ * @param data pointer to the data bytes
+ * @param len number of bytes
+ * @param rdfunc optional function used to read each data byte, for example
+ *	ReadPgmData() for data in program memory. If not given, data is in RAM.
+ * @param color BLACK writes the data as is, WHITE writes the inverse of the data
+ *
+ * The bytes are written to sequential columns starting at the current x,y position
+ * exactly as if WriteData() was called for each one, and the x position ends up
+ * just past the last byte written. Bytes that would land beyond the right edge of the
+ * display are dropped.
+ *
+ * When y is on a page boundary this is much faster than calling WriteData()
+ * for each byte since the bounds, chip and page crossing checks are done once
+ * per chip rather than once per byte.
+ *
+ * @see WriteData()
+ */
+
+void glcd_Device::WriteDataBlock(const uint8_t *data, uint8_t len, DataCallback rdfunc, uint8_t color)
+{
+	this->DoWriteBlock(data, len, rdfunc, color == BLACK ? 0 : 0xff, 1);
+}
+
+/*
+ * Write len bytes starting at data to sequential columns.
+ * Each byte is read with rdfunc (or directly from RAM if rdfunc is 0)
+ * and xor'd with xorval. data is advanced by step after each byte
+ * so a step of 0 repeats the same byte.
+ */
+void glcd_Device::DoWriteBlock(const uint8_t *data, uint8_t len, DataCallback rdfunc, uint8_t xorval, uint8_t step)
+{
+	uint8_t x, y, d;
+
+	this->BeginUpdate();
+	y = this->Dev->Coord.y;
+
+	if(y & 7)
+	{
+		/*
+		 * Not page aligned, each byte spans two pages so let WriteData() deal with it.
+		 */
+		while(len--)
+		{
+			d = rdfunc ? rdfunc(data) : *data;
+			this->WriteData(d ^ xorval);
+			data += step;
+		}
+		this->EndUpdate();
+		return;
+	}
+
+	if(this->Dev->Inverted)
+		xorval = ~xorval;
+
+	x = this->Dev->Coord.x;
+
+#ifdef GLCD_FRAMEBUFFER
+	while(len-- && x < DISPLAY_WIDTH)
+	{
+		d = (rdfunc ? rdfunc(data) : *data) ^ xorval;
+		data += step;
+		if(glcd_rdcache[y/8][x] != d)
+		{
+			glcd_rdcache[y/8][x] = d;
+			glcd_MarkDirty(y/8, x);
+		}
+		x++;
+	}
+	this->Dev->Coord.x = x;
+#else
+	if(len && x < DISPLAY_WIDTH)
+	{
+		uint8_t lx[glcd_LANES], lend[glcd_LANES], lchip[glcd_LANES];
+		uint8_t lane, first, last, xend, active = 0;
+
+		xend = len < DISPLAY_WIDTH - x ? x + len : DISPLAY_WIDTH;
+
+		/*
+		 * split the block into lanes, GotoXY() has already positioned
+		 * the first chip so only the others need positioning.
+		 */
+		first = x / CHIP_WIDTH;
+		last = (xend - 1) / CHIP_WIDTH;
+		for(lane = first; lane <= last; lane++)
+		{
+			lx[lane] = lane == first ? x : lane * CHIP_WIDTH;
+			lend[lane] = lane == last ? xend : glcd_LaneEnd(lane);
+			lchip[lane] = glcd_DevXYval2Chip(lx[lane], y);
+			if(lane != first)
+				this->DoGotoXY(lx[lane], y);
+			active |= _BV(lane);
+		}
+
+		/*
+		 * The glcd column address advances on its own after each write.
+		 */
+		while(active)
+		{
+			for(lane = first; lane <= last; lane++)
+			{
+				if(!(active & _BV(lane)))
+					continue;
+
+				d = (rdfunc ? rdfunc(data + (lx[lane] - x) * step) : data[(lx[lane] - x) * step]) ^ xorval;
+				this->DoWriteData(d, lchip[lane]);
+#ifdef GLCD_READ_CACHE
+				glcd_rdcache[y/8][lx[lane]] = d;
+#endif
+				if(++lx[lane] == lend[lane])
+					active &= ~_BV(lane);
+			}
+		}
+
+		/*
+		 * Same as WriteData(), x can end up one beyond the display
+		 * and the h/w is repositioned when the block ends on a chip boundary.
+		 */
+		this->Dev->Coord.x = xend;
+		if(xend < DISPLAY_WIDTH && glcd_DevXYval2Chip(xend, y) != lchip[last])
+		{
+			this->Dev->Coord.x = -1;
+			this->GotoXY(xend, y);
+		}
+	}
+#endif
+	this->EndUpdate();
+}
 
 /*
  * needed to resolve virtual print functions
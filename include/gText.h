@@ -53,6 +53,14 @@ typedef class _FlashString {} *FLASHSTRING;
 // zero length is flag indicating fixed width font (array does not contain width data entries)
 #define isFixedWidthFont(font)  (FontRead(font+FONT_LENGTH) == 0 && FontRead(font+FONT_LENGTH+1) == 0))
 
+#ifndef GLCD_TEXTRUN_SIZE
+#define GLCD_TEXTRUN_SIZE 16	// most characters of a string drawn together in one pass
+#endif
+
+#ifndef GLCD_GLYPH_CACHE_SIZE
+#define GLCD_GLYPH_CACHE_SIZE 32	// most bytes of glyph data a GLCD_GLYPH_CACHE entry holds
+#endif
+
 /*
  * Coodinates for predefined areas are compressed into a single 32 bit token.
  *
@@ -168,7 +176,6 @@ typedef const uint8_t* Font_t;
 typedef uint8_t (*FontCallback)(Font_t);
 
 uint8_t ReadPgmData(const uint8_t* ptr);	//Standard Read Callback
-static FontCallback	FontRead;               // font callback shared across all instances
 //static glcd_Device    *device;              // static pointer to the device instance
 
 /// @cond hide_from_doxygen
@@ -180,6 +187,15 @@ struct tarea
 	uint8_t y2;
 	int8_t  mode;
 };
+
+struct glcd_Glyph
+{
+	uint16_t index;	// offset of the glyph data in the font
+	uint8_t width;
+#ifdef GLCD_GLYPH_CACHE
+	const uint8_t *cached;	// glyph data in the glyph cache, 0 if it is not in it
+#endif
+};
 /// @endcond
 
 /**
@@ -206,6 +222,9 @@ class gText : public glcd_Device
 #endif
 
 	void SpecialChar(uint8_t c);
+	uint8_t FindGlyph(uint8_t c, uint8_t height, glcd_Glyph *g);
+	void PageGlyphs(const glcd_Glyph *g, uint8_t height, uint8_t thielefont, uint8_t jfirst, uint8_t jlast);
+	size_t PutRun(const char *str, size_t len, uint8_t progmem);
 
 	// Scroll routines are private for now
 	void ScrollUp(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t pixels, uint8_t color);
@@ -218,6 +237,12 @@ class gText : public glcd_Device
 	gText(predefinedArea selection, textMode mode=DEFAULT_SCROLLDIR);
 	gText(uint8_t x1, uint8_t y1, uint8_t columns, uint8_t rows, Font_t font, textMode mode=DEFAULT_SCROLLDIR);
 
+	// text areas on another display, device is the glcd object of that display
+	gText(const glcd_Device &device);
+	gText(const glcd_Device &device, uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, textMode mode=DEFAULT_SCROLLDIR);
+	gText(const glcd_Device &device, predefinedArea selection, textMode mode=DEFAULT_SCROLLDIR);
+	gText(const glcd_Device &device, uint8_t x1, uint8_t y1, uint8_t columns, uint8_t rows, Font_t font, textMode mode=DEFAULT_SCROLLDIR);
+
 	//void Init(glcd_Device* _device); // no longer used
 
 /** @name TEXT FUNCTIONS
@@ -236,7 +261,7 @@ class gText : public glcd_Device
 	void SelectFont(Font_t font, uint8_t color=BLACK, FontCallback callback=ReadPgmData); // default arguments added, callback now last arg
 	void SetFontColor(uint8_t color); // new method
 	int PutChar(uint8_t c);
-	void Puts(char *str);
+	void Puts(const char *str);
 	void Puts(const String &str); // for Arduino String Class
 	void Puts_P(PGM_P str);
 	void DrawString(char *str, uint8_t x, uint8_t y);
@@ -247,6 +272,8 @@ class gText : public glcd_Device
 	void write(uint8_t c);  // character output for print base class
 #else
 	size_t write(uint8_t c);  // character output for print base class
+	size_t write(const uint8_t *buffer, size_t size);  // string output for print base class
+	using Print::write;
 #endif
 
 	void CursorTo( uint8_t column, uint8_t row); // 0 based coordinates for character columns and rows
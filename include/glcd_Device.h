@@ -28,6 +28,20 @@
 #define GLCD_DEVICE_H
 
 #include "glcd_Config.h"
+#include "include/glcd_Panel.h"
+
+/*
+ * geometry of the configured panel, see glcd_Panel.h
+ */
+typedef glcd_PanelGeometry<DISPLAY_WIDTH, DISPLAY_HEIGHT, CHIP_WIDTH, CHIP_HEIGHT> glcd_Panel;
+
+#if defined(GLCD_FRAMEBUFFER) && !defined(GLCD_READ_CACHE)
+#define GLCD_READ_CACHE		// the frame buffer is the read cache
+#endif
+
+#if defined(GLCD_FRAMEBUFFER) && !defined(GLCD_XCOL_SUPPORT)
+#define GLCD_XCOL_SUPPORT	// Flush() is the only h/w writer so column tracking is exact
+#endif
 
 #if defined WIRING
 #include <WPrint.h> // used when deriving this class in Wiring
@@ -38,6 +52,14 @@
 
 #define GLCD_Device 1 // software version of this class
 
+#ifndef GLCD_BLOCKBUF_SIZE
+#define GLCD_BLOCKBUF_SIZE 32	// stack buffer size used for block read-modify-write
+#endif
+
+#ifndef GLCD_CLIP_DEPTH
+#define GLCD_CLIP_DEPTH 4		// number of clip areas PushClip() can save
+#endif
+
 #ifdef GLCD_BITSHIFT_COMMS
 void OutputByte(uint8_t data);
 uint8_t InputByte();
@@ -51,6 +73,14 @@ uint8_t InputByte();
 #define BLACK				0xFF
 #define WHITE				0x00
 
+typedef uint8_t (*DataCallback)(const uint8_t*);  // reads a data byte, see WriteDataBlock()
+
+typedef uint8_t flushMode;  // frame buffer flush policy, see SetFlushMode()
+
+const flushMode FLUSH_MANUAL = 0;	// only flush when Flush() is called
+const flushMode FLUSH_AUTO = 1;		// flush at the end of every drawing function
+const flushMode FLUSH_TIMED = 2;	// auto flush, but no more often than the flush interval
+
 /// @cond hide_from_doxygen
 typedef struct {
 	uint8_t x;
@@ -62,14 +92,67 @@ typedef struct {
 		uint8_t page;
 	} chip[glcd_CHIP_COUNT];
 } lcdCoord;
+
+typedef struct {
+	uint8_t x1;		// upper left corner
+	uint8_t y1;
+	uint8_t x2;		// lower right corner, inclusive. The area is empty if x1 > x2 or y1 > y2
+	uint8_t y2;
+} lcdClip;
 /// @endcond
-	
-/*
- * Note that all data in glcd_Device is static so that all derived instances  
- * (gText instances for example) share the same device state.
- * Any added data fields should also be static unless there is explicit reason
- * to not share the field among the instances 
+
+/**
+ * @class glcd_DeviceState
+ * @brief State of one physical display
+ *
+ * Every glcd_Device instance (gText text areas and glcd objects) points
+ * to the state of the display it draws on, so all the instances
+ * on a display share it while instances on different displays share nothing.
+ * The global GLCD object and the text areas created without a device
+ * use the default display.
+ *
+ * To drive another display, declare a glcd_DeviceState with a display
+ * number for it and a glcd object that uses it, then pass that object
+ * to the constructors of the text areas that go on it:
+ *
+ *	glcd_DeviceState display2State(1);
+ *	glcd GLCD2(display2State);
+ *	gText textArea2(GLCD2, textAreaTOP);
+ *
+ * All displays share the data bus and control lines. The configuration must
+ * define glcd_DevSelectDisplay(display) to route the chip select or enable
+ * lines to the given display, it is called before every glcd cycle.
+ *
+ * Any added device data fields should go here unless there is explicit reason
+ * to share the field among all displays.
  */
+class glcd_DeviceState
+{
+  public:
+	glcd_DeviceState(uint8_t display = 0);
+
+	lcdCoord		Coord;
+	uint8_t			Inverted;
+	uint8_t			Display;		// passed to glcd_DevSelectDisplay()
+	lcdClip			Clip;			// drawing is limited to this area, see PushClip()
+	lcdClip			ClipStack[GLCD_CLIP_DEPTH];	// areas saved by PushClip()
+	uint8_t			ClipDepth;
+#ifdef GLCD_TIMED_IO
+	uint8_t			BusySteps;		// calibrated busy wait, 0 polls the busy status
+#endif
+#ifdef GLCD_FRAMEBUFFER
+	uint8_t			UpdateDepth;	// nesting level of BeginUpdate()/EndUpdate()
+	flushMode		FlushMode;
+	uint16_t		FlushInterval;	// milliseconds, used by FLUSH_TIMED
+	unsigned long	FlushTime;		// millis() of the last flush
+	uint8_t			Dirty[DISPLAY_HEIGHT/8][(DISPLAY_WIDTH+7)/8];	// changed frame buffer columns
+#endif
+#ifdef GLCD_READ_CACHE
+	uint8_t			RdCache[DISPLAY_HEIGHT/8][DISPLAY_WIDTH];	// copy of the glcd memory
+#endif
+};
+
+extern glcd_DeviceState glcd_DefaultDisplay;
  
 /**
  * @class glcd_Device
@@ -82,6 +165,12 @@ class glcd_Device : public Print
   // Control functions
 	uint8_t DoReadData(void);
 	//void DoFakeReadData();
+	void DoGotoXY(uint8_t x, uint8_t y);
+	void DoWriteBlock(const uint8_t *data, uint8_t len, DataCallback rdfunc, uint8_t xorval, uint8_t step);
+	void DoWriteData(uint8_t data, uint8_t chip);
+#ifdef GLCD_TIMED_IO
+	void TimedSelfTest(void);
+#endif
 
 	void WriteCommand(uint8_t cmd, uint8_t chip);
 	inline void Enable(void);
@@ -96,16 +185,40 @@ class glcd_Device : public Print
 	
   public:
     glcd_Device();
+	explicit glcd_Device(glcd_DeviceState &state);
 	protected: 
     int Init(uint8_t invert = false);      // now public, default is non-inverted
-	void SetDot(uint8_t x, uint8_t y, uint8_t color);
-	void SetPixels(uint8_t x, uint8_t y,uint8_t x1, uint8_t y1, uint8_t color);
+	void SetDot(int16_t x, int16_t y, uint8_t color);
+	void SetPixels(int16_t x, int16_t y, int16_t x1, int16_t y1, uint8_t color);
+	uint8_t PushClip(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+	void PopClip(void);
+	void ResetClip(void);
     uint8_t ReadData(void);        // now public
+	void ReadDataBlock(uint8_t *buf, uint8_t len);
+	void ModifyData(uint8_t len, uint8_t andmask, uint8_t xormask);
+	void SetPixelMasks(const uint8_t *masks, uint8_t len, uint8_t color);
     void WriteData(uint8_t data); 
+	void WriteDataBlock(const uint8_t *data, uint8_t len, DataCallback rdfunc = 0, uint8_t color = BLACK);
 
   	void GotoXY(uint8_t x, uint8_t y);   
-    static lcdCoord	  	Coord;  
-	static uint8_t	 	Inverted; 
+
+#ifdef GLCD_FRAMEBUFFER
+	void Flush(void);
+	void SetFlushMode(flushMode mode, uint16_t interval = 0);
+	void BeginUpdate(void) { this->Dev->UpdateDepth++; }
+	void EndUpdate(void);
+#else
+	/*
+	 * Without a frame buffer all drawing goes straight to the display
+	 * so these do nothing. They exist so code can be written once for both.
+	 */
+	void Flush(void) {}
+	void SetFlushMode(flushMode, uint16_t = 0) {}
+	void BeginUpdate(void) {}
+	void EndUpdate(void) {}
+#endif
+
+	glcd_DeviceState	*Dev;	// the display this instance draws on
 };
   
 #endif
@@ -0,0 +1,69 @@
+/*
+  glcd_Panel.h - compile time panel geometry
+
+  vi:ts=4
+
+  This file is part of the Arduino GLCD library.
+
+  GLCD is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation, either version 2.1 of the License, or
+  (at your option) any later version.
+
+  GLCD is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with GLCD.  If not, see <http://www.gnu.org/licenses/>.
+
+  This file declares glcd_PanelGeometry, a template that describes a panel
+  made of a grid of identical controller chips, numbered left to right
+  then top to bottom.
+
+  Everything in it is a compile time constant or a static inline function of
+  those constants, so it costs no RAM and the compiler folds the chip mapping
+  down to shifts and masks (or nothing at all for a single chip).
+  Since the geometry is a type rather than a set of macros,
+  code can work with more than one panel geometry in the same build.
+
+  Device files use it to implement their glcd_DevXYval2Chip() and
+  glcd_DevXval2ChipCol() primitives for the configured panel via glcd_Panel.
+
+*/
+
+#ifndef	GLCD_PANEL_H
+#define GLCD_PANEL_H
+
+#include <inttypes.h>
+
+template <uint8_t width, uint8_t height, uint8_t chipWidth, uint8_t chipHeight>
+struct glcd_PanelGeometry
+{
+	static const uint8_t Width = width;
+	static const uint8_t Height = height;
+	static const uint8_t ChipWidth = chipWidth;
+	static const uint8_t ChipHeight = chipHeight;
+	static const uint8_t ChipCols = (width + chipWidth - 1) / chipWidth;	// chips across
+	static const uint8_t ChipRows = (height + chipHeight - 1) / chipHeight;	// chips down
+	static const uint8_t ChipCount = ChipCols * ChipRows;
+
+	/*
+	 * chip number that holds pixel x,y
+	 */
+	static inline uint8_t XYval2Chip(uint8_t x, uint8_t y)
+	{
+		return((ChipCols > 1 ? x / chipWidth : 0) + (ChipRows > 1 ? (y / chipHeight) * ChipCols : 0));
+	}
+
+	/*
+	 * column within its chip of pixel column x
+	 */
+	static inline uint8_t Xval2ChipCol(uint8_t x)
+	{
+		return(ChipCols > 1 ? x % chipWidth : x);
+	}
+};
+
+#endif // GLCD_PANEL_H
@@ -36,6 +36,7 @@
 #define GLCD_EBUSY		1	// glcd BUSY wait timeout
 #define GLCD_ERESET		2	// glcd RESET wait timeout
 #define GLCD_EINVAL		3	// invalid argument
+#define GLCD_EOVERFLOW	4	// no room left, e.g. the PushClip() stack is full
 
 
 
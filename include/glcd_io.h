@@ -33,6 +33,10 @@
 #else
 #include "Arduino.h"
 #endif
+
+#ifdef GLCD_SIMULATOR
+#include "include/glcd_sim.h"      // host side simulated glcd module
+#else
 #include "include/arduino_io.h"    // these macros map arduino pins
 
 /*
@@ -44,6 +48,7 @@
 #endif
 
 #include "include/avrio.h"         // these macros do direct port io    
+#endif
 
  
 /*
@@ -56,7 +61,61 @@
 #define GLCD_STATUS_BIT2PIN(bit)    xGLCD_STATUS_BIT2PIN(bit)    
 
 
-#ifdef  _AVRIO_AVRIO_
+#if defined(GLCD_SIMULATOR)
+
+/*
+ * Route all pin and data port i/o to the simulated module.
+ * Pin numbers are passed through as is, the model decodes them
+ * using the same glcdXXX pin defines as the configuration files.
+ */
+#define lcdfastWrite(pin, pinval) glcdsim_WritePin(pin, pinval)
+
+#ifndef OUTPUT
+#define OUTPUT 1
+#endif
+
+#ifndef LOW
+#define LOW 0
+#endif
+
+#ifndef HIGH
+#define HIGH 1
+#endif
+
+#define lcdPinMode(pin, mode)
+
+#ifdef GLCD_BITSHIFT_COMMS
+/*
+ * data port goes through the MCP23S17 (see glcd_Device.cpp)
+ * the model sits on the other side of the SPI bus.
+ */
+void lcdDataDir(uint8_t dirbits);
+void lcdDataOut(uint8_t data);
+uint8_t lcdDataIn(void);
+#define lcdRdBusystatus()		(lcdDataIn() & LCD_BUSY_FLAG)
+#else
+#define lcdDataDir(dirbits)		glcdsim_DataDir(dirbits)
+#define lcdDataOut(data)		glcdsim_DataOut(data)
+#define lcdDataIn()				glcdsim_DataIn()
+#define lcdRdBusystatus()		glcdsim_RdBusy()
+#endif
+
+#define lcdIsBusyStatus(status) (status & LCD_BUSY_FLAG)
+#define lcdIsResetStatus(status) (status & LCD_RESET_FLAG)
+
+#if GLCDSIM_DISPLAYS > 1 && !defined(glcd_DevSelectDisplay)
+#define glcd_DevSelectDisplay(display) glcdsim_SelectDisplay(display)
+#endif
+
+#ifdef glcdRES
+#define lcdReset()		glcdsim_WritePin(glcdRES, 0)
+#define lcdUnReset()	glcdsim_WritePin(glcdRES, 1)
+#else
+#define lcdReset()		
+#define lcdUnReset()		
+#endif
+
+#elif defined(_AVRIO_AVRIO_)
 
 // lcdfastWrite Macro may be replaced by Paul's new Arduino macro 
 #define lcdfastWrite(pin, pinval) avrio_WritePin(pin, pinval)
@@ -80,10 +139,13 @@
 #define lcd_avrReadByte() 
 #define lcd_avrWriteByte(data)
 
-//#define lcdDataDir(dirbits)	;chip23s17one.byteWrite(IODIRA, ~dirbits);	//0=output ff=input
-#define lcdDataDir(dirbits)
-//#define lcdDataOut(data)	OutputByte(data)
-//#define lcdDataIn()		InputByte()
+/*
+ * data port i/o is done through the MCP23S17 by functions in glcd_Device.cpp
+ * which track the port direction.
+ */
+void lcdDataDir(uint8_t dirbits);
+void lcdDataOut(uint8_t data);
+uint8_t lcdDataIn(void);
 
 #else
 /*
@@ -137,7 +199,11 @@
 /*
  * alias to read status bits
  */
+#ifdef GLCD_BITSHIFT_COMMS
+#define lcdRdBusystatus()		(lcdDataIn() & LCD_BUSY_FLAG)
+#else
 #define lcdRdBusystatus()		(avrio_ReadPin(GLCD_STATUS_BIT2PIN(LCD_BUSY_BIT)))
+#endif
 #define lcdRdResetstatus()		(avrio_ReadPin(GLCD_STATUS_BIT2PIN(LCD_RESET_BIT)))
 
 /*
@@ -157,6 +223,12 @@
 
 #endif // _AVRIO_AVRIO_
 
+/*
+ * set the DI and RW control lines
+ */
+#define setDI_RW(di,rw)  do {lcdfastWrite(glcdDI, di);lcdfastWrite(glcdRW, rw);}while(0)
+
+
 /*
  * Delay functions
  */
@@ -175,11 +247,18 @@
  * is sometimes smaller and doesn't use loops which require a
  * a register when the number cycles is less than 12.
  */
+#ifdef GLCD_SIMULATOR
+
+#define lcdDelayNanoseconds(__ns) glcdsim_Delay(__ns)	// advances the simulated bus clock
+#define lcdDelayMilliseconds(__ms) glcdsim_DelayMilliseconds(__ms)
+
+#else
 #include "include/delay.h" // Hans' Heirichs delay macros
 
 #define lcdDelayNanoseconds(__ns) _delay_cycles( (double)(F_CPU)*((double)__ns)/1.0e9 + 0.5 ) // Hans Heinrichs delay cycle routine
 
 #define lcdDelayMilliseconds(__ms) delay(__ms)	// Arduino delay function
+#endif
 
 
 /*
@@ -213,9 +292,6 @@
 #endif
 
 
-#define setDI_RW(di,rw)  do {lcdfastWrite(glcdDI, di);lcdfastWrite(glcdRW, rw);}while(0)
-
-
 #if defined(glcdCSEL4)
 #define lcdChipSelect(cselstr) lcdChipSelect4(cselstr)
 #elif defined(glcdCSEL3)
@@ -0,0 +1,131 @@
+/*
+  glcd_sim.h - host side simulated glcd module
+
+  vi:ts=4
+
+  This file is part of the Arduino GLCD library.
+
+  GLCD is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation, either version 2.1 of the License, or
+  (at your option) any later version.
+
+  GLCD is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with GLCD.  If not, see <http://www.gnu.org/licenses/>.
+
+  This file declares the interface to an in-memory model of the glcd module
+  (and the optional MCP23S17 port expander used by GLCD_BITSHIFT_COMMS).
+  It is only used when the library is built on a host with GLCD_SIMULATOR defined.
+  glcd_io.h maps all of the pin, data port and delay primitives used by
+  glcd_Device.cpp onto the functions below, so glcd_Device runs unmodified
+  against the model.
+
+  The model itself lives in debug/sim along with the host build.
+
+*/
+
+#ifndef	GLCD_SIM_H
+#define GLCD_SIM_H
+
+#include <inttypes.h>
+
+/*
+ * Bus cycle types.
+ * A cycle type is determined by the state of the DI and RW lines
+ * when E is strobed, which maps 1 to 1 onto the glcd_Device primitives:
+ *	GLCDSIM_CMD		WriteCommand()
+ *	GLCDSIM_WRITE	WriteData()
+ *	GLCDSIM_READ	ReadData() (includes the dummy reads)
+ *	GLCDSIM_STATUS	WaitReady() and GetStatus()
+ */
+#define GLCDSIM_CMD		0
+#define GLCDSIM_WRITE	1
+#define GLCDSIM_READ	2
+#define GLCDSIM_STATUS	3
+#define GLCDSIM_NCYCLES	4
+
+/*
+ * Default bus costs in nanoseconds.
+ * These approximate a 16Mhz AVR doing direct port i/o
+ * and an 8Mhz SPI clock to the MCP23S17.
+ * Any of them can be overridden on the compiler command line.
+ */
+#ifndef GLCDSIM_tIO
+#define GLCDSIM_tIO			125		// single pin or data port i/o operation
+#endif
+#ifndef GLCDSIM_tSPIBYTE
+#define GLCDSIM_tSPIBYTE	1000	// one byte on the SPI bus
+#endif
+#ifndef GLCDSIM_tBUSY
+#define GLCDSIM_tBUSY		1500	// controller busy time after a command or data cycle
+#endif
+
+/*
+ * Name of the configured panel for reports.
+ * The autoconfig panel files name the panel, the manual config files name the configuration.
+ */
+#if defined(glcd_PanelConfigName)
+#define GLCDSIM_PANELNAME	glcd_PanelConfigName
+#elif defined(glcd_ConfigName)
+#define GLCDSIM_PANELNAME	glcd_ConfigName
+#else
+#define GLCDSIM_PANELNAME	"unnamed panel"
+#endif
+
+/*
+ * Number of modules on the bus, see glcdsim_SelectDisplay()
+ */
+#ifndef GLCDSIM_DISPLAYS
+#define GLCDSIM_DISPLAYS	1
+#endif
+
+/// @cond hide_from_doxygen
+typedef struct
+{
+	uint32_t cycles[GLCDSIM_NCYCLES];	// E strobes by cycle type
+	uint64_t ns[GLCDSIM_NCYCLES];		// bus time by cycle type
+	uint32_t polls;						// busy bit samples
+	uint32_t spi;						// SPI transactions (chip select assertions)
+	uint32_t spibytes;					// bytes moved over SPI
+	uint32_t overruns;					// cycles issued while the controller was busy
+} glcdsim_stats_t;
+/// @endcond
+
+extern glcdsim_stats_t glcdsim_stats;
+
+/*
+ * simulator control and inspection
+ */
+void glcdsim_Reset(void);				// power on reset of the module and counters
+void glcdsim_ClearStats(void);
+uint64_t glcdsim_BusTime(void);			// total bus time in ns since last ClearStats
+uint64_t glcdsim_Clock(void);			// simulated time in ns since reset
+uint8_t glcdsim_GetPixel(uint8_t x, uint8_t y);	// 1 if pixel is dark in module RAM
+uint8_t glcdsim_ReadRAM(uint8_t chip, uint8_t page, uint8_t col);
+uint32_t glcdsim_Checksum(void);		// hash of the visible module RAM
+void glcdsim_SetBusyTime(uint32_t ns);	// inject a slower (or faster) controller
+void glcdsim_SelectDisplay(uint8_t display);	// also used by glcd_io.h
+
+/*
+ * i/o primitives used by glcd_io.h
+ */
+void glcdsim_WritePin(uint8_t pin, uint8_t val);
+void glcdsim_DataDir(uint8_t dirbits);
+void glcdsim_DataOut(uint8_t data);
+uint8_t glcdsim_DataIn(void);
+uint8_t glcdsim_RdBusy(void);
+void glcdsim_Delay(uint32_t ns);
+void glcdsim_DelayMilliseconds(uint32_t ms);
+
+/*
+ * SPI bus primitives used by the host SPI library (MCP23S17 model)
+ */
+void glcdsim_SpiSelect(uint8_t level);
+uint8_t glcdsim_SpiTransfer(uint8_t data);
+
+#endif // GLCD_SIM_H